@@ -0,0 +1,43 @@
+#ifndef BANTRIE_HPP
+#define BANTRIE_HPP
+
+#include <string>
+#include "NetMask.hpp"
+
+// Address bans (D-lines) in a path-compressed binary (Patricia) trie over
+// the 128-bit key space NetMask uses, so IPv4 and IPv6 prefixes live in
+// one tree. A lookup walks at most one node per distinct prefix length
+// on the path, independent of the number of bans.
+class BanTrie {
+private:
+    struct Node {
+        NetMask prefix;
+        bool banned;
+        std::string reason;
+        Node* child[2];
+
+        Node(const NetMask& prefix);
+    };
+
+    Node* root;
+    size_t count;
+
+    BanTrie(const BanTrie& other);
+    BanTrie& operator=(const BanTrie& other);
+
+    static void destroy(Node* node);
+    static int commonBits(const NetMask& a, const NetMask& b, int limit);
+
+public:
+    BanTrie();
+    ~BanTrie();
+
+    void insert(const NetMask& prefix, const std::string& reason);
+    const std::string* match(const NetMask& address) const;
+    void loadFile(const std::string& path);
+    void swap(BanTrie& other);
+    void clear();
+    size_t size() const;
+};
+
+#endif
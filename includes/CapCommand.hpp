@@ -0,0 +1,17 @@
+#ifndef CAPCOMMAND_HPP
+#define CAPCOMMAND_HPP
+
+#include "Command.hpp"
+
+class CapCommand : public Command {
+private:
+    void reply(const std::string& subcommand, const std::string& caps);
+
+public:
+    CapCommand(Server* srv, Client* cli, const std::vector<std::string>& params);
+    ~CapCommand();
+    
+    void execute();
+};
+
+#endif
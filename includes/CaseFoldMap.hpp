@@ -0,0 +1,134 @@
+#ifndef CASEFOLDMAP_HPP
+#define CASEFOLDMAP_HPP
+
+#include <string>
+#include <vector>
+#include "CaseMapping.hpp"
+
+// Hash table from IRC names (compared with RFC 1459 casemapping) to
+// values. Open addressing with linear probing and backward-shift
+// deletion; lookups hash and compare the caller's bytes in place, so
+// they never allocate. find() returns T() when the name is absent.
+template <typename T>
+class CaseFoldMap {
+private:
+    struct Entry {
+        std::string key;
+        uint64_t hash;
+        T value;
+        bool used;
+
+        Entry() : hash(0), value(), used(false) {}
+    };
+
+    std::vector<Entry> table;
+    size_t count;
+
+    size_t locate(const char* key, size_t len, uint64_t hash) const {
+        size_t mask = table.size() - 1;
+        size_t i = hash & mask;
+        while (table[i].used) {
+            if (table[i].hash == hash
+                && ircEquals(table[i].key.data(), table[i].key.length(), key, len))
+                return i;
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void grow() {
+        std::vector<Entry> old;
+        old.swap(table);
+        table.resize(old.empty() ? 16 : old.size() * 2);
+        size_t mask = table.size() - 1;
+        for (size_t i = 0; i < old.size(); i++) {
+            if (!old[i].used)
+                continue;
+            size_t j = old[i].hash & mask;
+            while (table[j].used)
+                j = (j + 1) & mask;
+            table[j].key.swap(old[i].key);
+            table[j].hash = old[i].hash;
+            table[j].value = old[i].value;
+            table[j].used = true;
+        }
+    }
+
+public:
+    CaseFoldMap() : count(0) {}
+
+    T find(const char* key, size_t len) const {
+        if (count == 0)
+            return T();
+        size_t i = locate(key, len, ircHash(key, len));
+        return table[i].used ? table[i].value : T();
+    }
+
+    T find(const std::string& key) const {
+        return find(key.data(), key.length());
+    }
+
+    // Inserts or replaces the value stored under 'key'.
+    void insert(const std::string& key, T value) {
+        if ((count + 1) * 4 > table.size() * 3)
+            grow();
+        uint64_t hash = ircHash(key.data(), key.length());
+        size_t i = locate(key.data(), key.length(), hash);
+        if (!table[i].used) {
+            table[i].key = key;
+            table[i].hash = hash;
+            table[i].used = true;
+            count++;
+        }
+        table[i].value = value;
+    }
+
+    bool erase(const std::string& key) {
+        if (count == 0)
+            return false;
+        size_t mask = table.size() - 1;
+        size_t i = locate(key.data(), key.length(), ircHash(key.data(), key.length()));
+        if (!table[i].used)
+            return false;
+        // Shift later entries of the probe run back into the hole so no
+        // tombstones are needed.
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & mask;
+            if (!table[j].used)
+                break;
+            size_t home = table[j].hash & mask;
+            if ((j > i && (home <= i || home > j)) || (j < i && (home <= i && home > j))) {
+                table[i].key.swap(table[j].key);
+                table[i].hash = table[j].hash;
+                table[i].value = table[j].value;
+                i = j;
+            }
+        }
+        table[i].key.clear();
+        table[i].value = T();
+        table[i].used = false;
+        count--;
+        return true;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Bytes held by the slot table itself (keys' heap storage excluded).
+    size_t tableBytes() const {
+        return table.capacity() * sizeof(Entry);
+    }
+
+    // Snapshot of every stored value, for whole-table walks (teardown).
+    void values(std::vector<T>& out) const {
+        out.reserve(out.size() + count);
+        for (size_t i = 0; i < table.size(); i++) {
+            if (table[i].used)
+                out.push_back(table[i].value);
+        }
+    }
+};
+
+#endif
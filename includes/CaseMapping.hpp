@@ -0,0 +1,27 @@
+#ifndef CASEMAPPING_HPP
+#define CASEMAPPING_HPP
+
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+
+// RFC 1459 casemapping: A-Z[\]^ are the upper-case forms of a-z{|}~,
+// so "Nick[1]" and "nick{1}" are the same name.
+inline unsigned char ircToLower(unsigned char c) {
+    if (c >= 'A' && c <= '^')
+        return c + ('a' - 'A');
+    return c;
+}
+
+std::string ircCasefold(const std::string& str);
+bool ircEquals(const char* a, size_t aLen, const char* b, size_t bLen);
+
+// Keyed SipHash-1-3 of the casefolded bytes. The key is drawn from
+// /dev/urandom once per process, so clients cannot pick names that all
+// collide in a hash table (hash flooding).
+uint64_t ircHash(const char* data, size_t len);
+
+// Same keyed hash over raw bytes, for binary keys such as addresses.
+uint64_t keyedHash(const char* data, size_t len);
+
+#endif
@@ -3,30 +3,52 @@
 
 #include <string>
 #include <set>
+#include <vector>
 #include "../includes/Server.hpp"
+#include "../includes/ChannelHistory.hpp"
+
+#define MEMBER_OP    0x01
+#define MEMBER_VOICE 0x02
 
 class Client;
+class SharedMessage;
+
+// One slot of a channel's member table. Slots are kept dense so
+// broadcasts walk contiguous memory; each client remembers its slot
+// index per channel (see Client::getChannelSlot).
+struct Membership {
+    Client* client;
+    unsigned char modes;
+};
 
 class Channel {
 private:
     std::string name;
+    std::string foldedName;
     std::string topic;
     std::string key;
     int userLimit;
-    std::set<Client*> members;
-    std::set<Client*> operators;
+    std::vector<Membership> members;
+    size_t operatorCount;
     std::set<Client*> invitedUsers;
     bool inviteOnly;
     bool topicRestricted;
     Server* server;
+    ChannelHistory history;
+
+    Membership* findMember(Client* client);
+    const Membership* findMember(Client* client) const;
+    bool detachMember(Client* client);
 
 public:
     Channel(const std::string& name, Server* srv);
     ~Channel();
     
-    std::string getName() const;
-    std::string getTopic() const;
-    std::set<Client*> getMembers() const;
+    const std::string& getName() const;
+    const std::string& getFoldedName() const;
+    const std::string& getTopic() const;
+    const std::vector<Membership>& getMembers() const;
+    ChannelHistory& getHistory();
     bool        getRestriction() const;
     
     void setTopic(const std::string& topic, Client* client);
@@ -42,7 +64,8 @@ public:
     bool isOperator(Client* client) const;
     bool isMember(Client* client) const;
     
-    void broadcast(const std::string& msg, Client* exclude);
+    void broadcast(const std::string& msg, Client* exclude, bool droppable = false);
+    void broadcast(SharedMessage* msg, Client* exclude);
     void setInviteOnly(bool mode, Client* client);
     void setTopicRestricted(bool mode, Client* client);
     void setUserLimit(int limit, Client* client);
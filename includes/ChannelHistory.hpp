@@ -0,0 +1,83 @@
+#ifndef CHANNELHISTORY_HPP
+#define CHANNELHISTORY_HPP
+
+#include <string>
+#include <vector>
+#include <list>
+#include "HistoryIndex.hpp"
+
+class Channel;
+class Client;
+class SharedMessage;
+
+// Batch reference tag carried by every stored line. A replay is queued
+// in one go, so no two history batches are ever open at the same time
+// on a connection and one fixed reference is enough.
+#define HISTORY_BATCH "history"
+
+// A CHATHISTORY message reference: msgid=<n> or timestamp=<ISO 8601>,
+// the latter kept in milliseconds since the epoch.
+struct HistoryRef {
+    bool byId;
+    unsigned long value;
+};
+
+// Recent PRIVMSG/NOTICE lines of one channel, oldest first, in a ring
+// that grows up to the configured number of lines. Each line is stored
+// once as a tagged SharedMessage ("@batch=...;time=...;msgid=<n> ..."),
+// and a replay to a client that enabled message-tags and batch queues
+// those buffers themselves, so serving history copies nothing. Other
+// clients get a copy of each line with the tags cut off. The text of
+// every line also goes into a HistoryIndex for SEARCH, and counts
+// towards the same byte total.
+// Server keeps every non-empty history on an LRU list to enforce the
+// global memory budget.
+class ChannelHistory {
+private:
+    struct Entry {
+        unsigned long id;
+        unsigned long timeMs;
+        SharedMessage* line;
+        size_t postings;
+    };
+
+    std::vector<Entry> ring;
+    size_t start;
+    size_t count;
+    size_t bytes;
+    HistoryIndex index;
+    std::list<Channel*>::iterator lruPos;
+    bool listed;
+
+    ChannelHistory(const ChannelHistory& other);
+    ChannelHistory& operator=(const ChannelHistory& other);
+
+    const Entry& at(size_t pos) const;
+    unsigned long keyAt(size_t pos, bool byId) const;
+
+public:
+    ChannelHistory();
+    ~ChannelHistory();
+
+    void append(unsigned long id, unsigned long timeMs, SharedMessage* line,
+                const std::string& text, size_t capacity);
+    void dropOldest();
+    void clear();
+    size_t size() const;
+    size_t getBytes() const;
+
+    size_t countBefore(const HistoryRef& ref) const;
+    size_t countUpTo(const HistoryRef& ref) const;
+    void replay(Client* client, size_t first, size_t last, bool tagged) const;
+    void search(const std::string& query, size_t limit, std::vector<size_t>& positions) const;
+
+    bool isListed() const;
+    std::list<Channel*>::iterator getLruPosition() const;
+    void setLruPosition(std::list<Channel*>::iterator pos);
+    void unlist();
+
+    static std::string formatTime(unsigned long timeMs);
+    static bool parseRef(const std::string& str, HistoryRef& ref);
+};
+
+#endif
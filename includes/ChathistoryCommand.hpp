@@ -0,0 +1,17 @@
+#ifndef CHATHISTORYCOMMAND_HPP
+#define CHATHISTORYCOMMAND_HPP
+
+#include "Command.hpp"
+
+class ChathistoryCommand : public Command {
+private:
+    void fail(const char* code, const std::string& context, const char* description);
+
+public:
+    ChathistoryCommand(Server* srv, Client* cli, const std::vector<std::string>& params);
+    ~ChathistoryCommand();
+    
+    void execute();
+};
+
+#endif
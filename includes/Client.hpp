@@ -2,9 +2,27 @@
 #define CLIENT_HPP
 
 #include <string>
-#include <set>
+#include <map>
+#include <deque>
+#include <ctime>
+#include "StringView.hpp"
+#include "TimerWheel.hpp"
+#include "NetMask.hpp"
+
+#define INPUT_BUFFER_SIZE 4096
+#define NO_CHANNEL_SLOT static_cast<size_t>(-1)
+
+// IRCv3 capabilities a client can enable with CAP REQ
+#define CAP_MESSAGE_TAGS 0x01
+#define CAP_BATCH        0x02
+#define CAP_SERVER_TIME  0x04
+#define CAP_CHATHISTORY  0x08
 
 class Channel;
+class Server;
+class SharedMessage;
+class NumericReply;
+struct ConnectionClass;
 
 class Client {
 private:
@@ -13,24 +31,64 @@ private:
     std::string username;
     std::string realname;
     std::string hostname;
+    std::string address;
+    NetMask source;
+    bool sourceCounted;
+    std::string prefix;
     bool authenticated;
     bool registered;
-    std::string buffer;
-    std::set<Channel*> channels;
+    unsigned int caps;
+    bool capNegotiating;
+    char inBuffer[INPUT_BUFFER_SIZE];
+    size_t inStart;
+    size_t inScanned;
+    size_t inEnd;
+    bool inDiscarding;
+    std::deque<SharedMessage*> sendQueue;
+    size_t sendOffset;
+    bool writeWatched;
+    bool flushScheduled;
+    size_t queuedSinceFlush;
+    size_t sendQueueBytes;
+    bool congested;
+    bool sendqExceeded;
+    const ConnectionClass* connectionClass;
+    unsigned long messagesQueued;
+    unsigned long droppedMessages;
+    unsigned long bytesSent;
+    unsigned long linesReceived;
+    unsigned long bytesReceived;
+    time_t connectedAt;
+    std::map<Channel*, size_t> channels;
+    Server* server;
+    TimerNode keepaliveTimer;
+    unsigned long lastActivity;
+    bool awaitingPong;
+    unsigned long neighbourMark;
+    TimerNode floodTimer;
+    unsigned long floodClock;
+    bool readPaused;
+
+    void rebuildPrefix();
+    bool admitOutput(size_t len, bool droppable);
+    void accountQueued(size_t len);
 
 public:
-    Client(int fd);
+    Client(int fd, Server* srv);
     ~Client();
     
     int getFd() const;
-    std::string getRealname() const;
-    std::string getHostname() const;    
-    std::string getNickname() const;
-    std::string getUsername() const;
-    std::string getPrefix() const;
-    std::set<Channel*> getChannels() const;
+    const std::string& getRealname() const;
+    const std::string& getHostname() const;
+    const std::string& getNickname() const;
+    const std::string& getUsername() const;
+    const std::string& getPrefix() const;
+    const std::map<Channel*, size_t>& getChannels() const;
     bool isAuthenticated() const;
     bool isRegistered() const;
+    bool hasCaps(unsigned int mask) const;
+    unsigned int getCaps() const;
+    bool isCapNegotiating() const;
     
     void setRealname(const std::string& real);
     void setHostname(const std::string& host);
@@ -39,11 +97,54 @@ public:
     void authenticate();
     void unauthenticate();
     void registerClient();
-    void addToChannel(Channel* channel);
+    void setCaps(unsigned int caps);
+    void setCapNegotiating(bool negotiating);
+    void addToChannel(Channel* channel, size_t slot);
     void removeFromChannel(Channel* channel);
-    void appendToBuffer(const std::string& data);
-    std::string extractCommand();
+    size_t getChannelSlot(Channel* channel) const;
+    void setChannelSlot(Channel* channel, size_t slot);
+    size_t prepareRead(char*& dst);
+    void commitRead(size_t len);
+    bool extractLine(StringView& line);
     void sendMessage(const std::string& msg);
+    void sendMessage(SharedMessage* msg);
+    void sendMessage(const char* msg, size_t len);
+    void sendReply(const NumericReply& reply);
+    bool hasPendingOutput() const;
+    int flushOutput();
+    bool isSendqExceeded() const;
+    void abortOutput(const std::string& last);
+    bool isWriteWatched() const;
+    void setWriteWatched(bool watched);
+    bool isFlushScheduled() const;
+    void setFlushScheduled(bool scheduled);
+    size_t getQueuedSinceFlush() const;
+    TimerNode* getKeepaliveTimer();
+    void touch(unsigned long tick);
+    unsigned long getLastActivity() const;
+    bool isAwaitingPong() const;
+    void setAwaitingPong(bool awaiting);
+    bool markNeighbour(unsigned long epoch);
+    TimerNode* getFloodTimer();
+    bool isFlooding(unsigned long nowMs) const;
+    void chargeFlood(unsigned int costMs, unsigned long nowMs);
+    unsigned long getFloodResumeMs() const;
+    bool isReadPaused() const;
+    void setReadPaused(bool paused);
+    void setAddress(const std::string& addr);
+    const std::string& getAddress() const;
+    void setSource(const NetMask& src, bool counted);
+    const NetMask& getSource() const;
+    bool isSourceCounted() const;
+    void setConnectionClass(const ConnectionClass* cls);
+    const ConnectionClass* getConnectionClass() const;
+    size_t getSendQueueBytes() const;
+    unsigned long getMessagesQueued() const;
+    unsigned long getDroppedMessages() const;
+    unsigned long getBytesSent() const;
+    unsigned long getLinesReceived() const;
+    unsigned long getBytesReceived() const;
+    time_t getConnectedAt() const;
 };
 
 #endif
@@ -12,7 +12,7 @@ class Command {
 protected:
     Server* server;
     Client* client;
-    std::vector<std::string> params;
+    const std::vector<std::string>& params;
     
     std::string formatCode(int code);
     std::string getClientNick();
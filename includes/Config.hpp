@@ -0,0 +1,67 @@
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include <string>
+#include <vector>
+#include "NetMask.hpp"
+
+// Limits shared by every connection whose address matches 'hosts'.
+struct ConnectionClass {
+    std::string name;
+    std::vector<NetMask> hosts;
+    size_t sendqMax;
+    size_t sendqHigh;
+    size_t sendqLow;
+    bool dropLowPriority;
+    unsigned long floodBurst;
+    bool floodExempt;
+    unsigned int maxPerIp;
+    unsigned long connectBurst;
+    unsigned long connectRate;
+    int limitCidr;
+
+    ConnectionClass(const std::string& name);
+};
+
+// Optional server configuration file, INI style:
+//
+//   [server]
+//   listen_backlog = 128
+//   dline_file = bans.txt
+//   history_lines = 100
+//   history_memory = 16M
+//
+//   [class bots]
+//   hosts = 10.0.0.0/8 192.168.1.5
+//   sendq_max = 4M
+//   flood_exempt = yes
+//
+// Connections use the first class whose hosts match their address, and
+// the "default" class otherwise. Errors throw std::runtime_error.
+class Config {
+private:
+    std::vector<ConnectionClass> classes;
+    int listenBacklog;
+    std::string dlineFile;
+    size_t historyLines;
+    size_t historyMemory;
+
+    void setServerValue(const std::string& key, const std::string& value, int lineNo);
+    void setClassValue(ConnectionClass& cls, const std::string& key,
+                       const std::string& value, int lineNo);
+    void validate() const;
+
+public:
+    Config();
+    ~Config();
+
+    void load(const std::string& path);
+    const ConnectionClass& findClass(const NetMask& address) const;
+    const std::vector<ConnectionClass>& getClasses() const;
+    int getListenBacklog() const;
+    const std::string& getDlineFile() const;
+    size_t getHistoryLines() const;
+    size_t getHistoryMemory() const;
+};
+
+#endif
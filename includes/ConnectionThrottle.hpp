@@ -0,0 +1,56 @@
+#ifndef CONNECTIONTHROTTLE_HPP
+#define CONNECTIONTHROTTLE_HPP
+
+#include <vector>
+#include <stdint.h>
+#include "NetMask.hpp"
+
+struct ConnectionClass;
+
+// Per-source admission control, consulted right after accept() and
+// before any Client exists. A source is the peer address cut to the
+// class's limit_cidr (IPv4) or /64 (IPv6), so a NAT or a v6 subnet
+// counts as one. Each source tracks its open connections and a connect
+// score that rises by one per attempt and drains at connect_rate per
+// second. Sources with nothing open and a drained score are dropped the
+// next time the table fills up. Connections of a class with no limits
+// are let in as EXEMPT without being counted, and must not be released.
+class ConnectionThrottle {
+public:
+    enum Verdict {
+        ADMITTED,
+        EXEMPT,
+        TOO_MANY_CONNECTIONS,
+        TOO_FAST
+    };
+
+private:
+    struct Entry {
+        NetMask source;
+        uint64_t hash;
+        unsigned int connections;
+        unsigned long score;
+        unsigned long rate;
+        unsigned long updatedMs;
+        bool used;
+
+        Entry() : hash(0), connections(0), score(0), rate(0), updatedMs(0), used(false) {}
+    };
+
+    std::vector<Entry> table;
+    size_t count;
+
+    size_t locate(const NetMask& source, uint64_t hash) const;
+    void rebuild(unsigned long nowMs);
+    static void decay(Entry& entry, unsigned long nowMs);
+
+public:
+    ConnectionThrottle();
+
+    static NetMask sourceOf(const NetMask& address, const ConnectionClass& cls);
+    Verdict admit(const NetMask& source, const ConnectionClass& cls, unsigned long nowMs);
+    void release(const NetMask& source);
+    size_t size() const;
+};
+
+#endif
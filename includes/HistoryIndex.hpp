@@ -0,0 +1,53 @@
+#ifndef HISTORYINDEX_HPP
+#define HISTORYINDEX_HPP
+
+#include <string>
+#include <vector>
+#include "CaseFoldMap.hpp"
+#include "StringView.hpp"
+
+// Inverted index over one channel's history, updated as each line is
+// stored. Every token maps to the ids of the messages containing it, kept
+// as varint-encoded gaps: ids only grow, so a posting is appended to in
+// place and most gaps fit in one byte. Tokens are casefolded runs of
+// letters, digits and non-ASCII bytes, at least two bytes long.
+//
+// Postings of messages that left the history are dropped lazily: once
+// they outnumber the live ones, every list loses its (leading) dead ids
+// in one pass.
+class HistoryIndex {
+private:
+    struct Posting {
+        std::string token;
+        std::string gaps;
+        unsigned long lastId;
+        size_t count;
+    };
+
+    CaseFoldMap<Posting*> postings;
+    size_t livePostings;
+    size_t deadPostings;
+    size_t bytes;
+
+    HistoryIndex(const HistoryIndex& other);
+    HistoryIndex& operator=(const HistoryIndex& other);
+
+    void prune(unsigned long oldestId);
+    static void decode(const Posting& posting, unsigned long oldestId,
+                       std::vector<unsigned long>& ids);
+
+public:
+    HistoryIndex();
+    ~HistoryIndex();
+
+    size_t add(unsigned long id, const std::string& text);
+    void retire(size_t count, unsigned long oldestId);
+    void search(const std::string& query, unsigned long oldestId,
+                std::vector<unsigned long>& ids) const;
+    void clear();
+    size_t getBytes() const;
+
+    static void tokenize(const std::string& text, std::vector<StringView>& tokens);
+};
+
+#endif
@@ -3,20 +3,45 @@
 
 #include <string>
 #include <vector>
+#include "StringView.hpp"
+
+#define MAX_PARAMS 15
 
 class Server;
 class Client;
-class Command;
+
+typedef void (*CommandHandler)(Server* srv, Client* cli,
+    const std::vector<std::string>& params);
+
+#define UNKNOWN_COMMAND_COST 1000
+
+// One row of the dispatch table, with the usage counters STATS m reports.
+// cost is the fake lag, in milliseconds, charged to the sender per use.
+struct CommandEntry {
+    const char* name;
+    CommandHandler handler;
+    unsigned int cost;
+    unsigned long calls;
+    unsigned long bytes;
+};
+
+// A parsed line. Every field is a view into the line that was parsed and
+// is only valid as long as that line is.
+struct IrcMessage {
+    StringView tags;
+    StringView prefix;
+    StringView command;
+    StringView params[MAX_PARAMS];
+    size_t paramCount;
+};
 
 class MessageParser {
 private:
-    static std::vector<std::string> splitParams(const std::string& str);
-    static std::string extractPrefix(const std::string& line);
-    static std::string removePrefix(const std::string& line);
-    static Command* createCommand(const std::string& cmd, Server* srv, Client* cli,
-        const std::vector<std::string>& params);
+    static CommandEntry* findCommand(const StringView& cmd);
 public:
-    static Command* parse(const std::string& line, Server* srv, Client* cli);
+    static bool parse(const StringView& line, IrcMessage& msg);
+    static unsigned int dispatch(const StringView& line, Server* srv, Client* cli);
+    static const CommandEntry* getCommandTable(size_t& count);
 };
 
 #endif
@@ -0,0 +1,25 @@
+#ifndef NETMASK_HPP
+#define NETMASK_HPP
+
+#include <string>
+#include <sys/socket.h>
+
+// An IPv4 or IPv6 prefix such as "10.0.0.0/8", "2001:db8::/32" or a bare
+// address (full-length prefix). IPv4 addresses are kept as IPv4-mapped
+// IPv6 (::ffff:a.b.c.d) so both families share one 128-bit key space.
+struct NetMask {
+    unsigned char addr[16];
+    int bits;
+
+    NetMask();
+
+    static bool parse(const std::string& str, NetMask& out);
+    static bool fromSockaddr(const struct sockaddr* sa, NetMask& out);
+    bool contains(const NetMask& address) const;
+    bool isIPv4() const;
+    void truncate(int prefix);
+    bool bitAt(int index) const;
+    std::string toString() const;
+};
+
+#endif
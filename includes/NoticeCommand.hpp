@@ -1,14 +1,12 @@
 #ifndef NOTICECOMMAND_HPP
 #define NOTICECOMMAND_HPP
 
-#include "Command.hpp"
+#include "PrivmsgCommand.hpp"
 
-class NoticeCommand : public Command {
+class NoticeCommand : public PrivmsgCommand {
 public:
     NoticeCommand(Server* srv, Client* cli, const std::vector<std::string>& params);
     ~NoticeCommand();
-    
-    void execute();
 };
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef NUMERICREPLY_HPP
+#define NUMERICREPLY_HPP
+
+#include <string>
+#include "StringView.hpp"
+
+#define MAX_LINE_LENGTH 512
+
+// One numeric reply, ":<server> NNN <target> [args] [:trailing]", built
+// in place on the stack. Anything past the 512-byte line limit (CRLF
+// included) is cut off. Queued with Client::sendReply, which copies it
+// once into the client's output buffer and adds the CRLF.
+class NumericReply {
+private:
+    char buffer[MAX_LINE_LENGTH - 2];
+    size_t len;
+
+    void putCode(int code);
+    void put(const char* s, size_t n);
+
+public:
+    NumericReply(int code, const std::string& target);
+    NumericReply(int code, const char* target);
+
+    NumericReply& arg(const std::string& s);
+    NumericReply& arg(const char* s);
+    NumericReply& arg(const StringView& s);
+    NumericReply& arg(unsigned long n);
+    NumericReply& trailing(const std::string& s);
+    NumericReply& trailing(const char* s);
+    NumericReply& append(const std::string& s);
+    NumericReply& append(const char* s);
+
+    const char* data() const;
+    size_t length() const;
+};
+
+#endif
@@ -4,10 +4,23 @@
 #include "Command.hpp"
 #include "Client.hpp"
 #include "Server.hpp"
+#include "StringView.hpp"
 
+// PRIVMSG <target>{,<target>} <text>. The sender prefix and the text are
+// serialized once per command; each target only adds its own name, and a
+// channel target is queued on all of its members as one shared buffer.
+// NOTICE goes through the same path with every error reply suppressed.
 class PrivmsgCommand : public Command {
 private:
-    void    executeSingle(const std::string &receptor);
+    const char* verb;
+    bool quiet;
+
+    bool    resolveTarget(const StringView& target, Channel*& channel, Client*& user);
+
+protected:
+    PrivmsgCommand(Server* srv, Client* cli, const std::vector<std::string>& params,
+                   const char* verb, bool quiet);
+
 public:
     PrivmsgCommand(Server* srv, Client* cli, const std::vector<std::string>& params);
     ~PrivmsgCommand();
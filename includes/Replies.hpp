@@ -2,130 +2,168 @@
 #define REPLIES_HPP
 
 #include <string>
+#include "NumericReply.hpp"
 
 // Server name constant
 #define SERVER_NAME "ircserv"
 #define SERVER_VERSION "1.0"
 
+// Most targets a single PRIVMSG/NOTICE may address (TARGMAX)
+#define MAX_TARGETS 32
+
+// Most lines a single CHATHISTORY request replays
+#define HISTORY_REPLAY_MAX 100
+
+#define STRINGIFY_(x) #x
+#define STRINGIFY(x) STRINGIFY_(x)
+
 // ============================================================================
-// WELCOME MESSAGES (001-004)
+// WELCOME MESSAGES (001-005)
 // ============================================================================
 #define RPL_WELCOME(nick, user, host) \
-    (":" SERVER_NAME " 001 " + (nick) + " :Welcome to the IRC Network " + (nick) + "!" + (user) + "@" + (host))
+    NumericReply(1, nick).trailing("Welcome to the IRC Network ").append(nick) \
+        .append("!").append(user).append("@").append(host)
 
 #define RPL_YOURHOST(nick) \
-    (":" SERVER_NAME " 002 " + (nick) + " :Your host is " SERVER_NAME ", running version " SERVER_VERSION)
+    NumericReply(2, nick).trailing("Your host is " SERVER_NAME ", running version " SERVER_VERSION)
 
 #define RPL_CREATED(nick, date) \
-    (":" SERVER_NAME " 003 " + (nick) + " :This server was created " + (date))
+    NumericReply(3, nick).trailing("This server was created ").append(date)
 
 #define RPL_MYINFO(nick) \
-    (":" SERVER_NAME " 004 " + (nick) + " " SERVER_NAME " " SERVER_VERSION " o itkol")
+    NumericReply(4, nick).arg(SERVER_NAME " " SERVER_VERSION " o itkol")
+
+#define RPL_ISUPPORT(nick) \
+    NumericReply(5, nick).arg("CASEMAPPING=rfc1459 CHANTYPES=#& " \
+        "TARGMAX=PRIVMSG:" STRINGIFY(MAX_TARGETS) ",NOTICE:" STRINGIFY(MAX_TARGETS) \
+        " CHATHISTORY=" STRINGIFY(HISTORY_REPLAY_MAX) " MSGREFTYPES=timestamp,msgid") \
+        .trailing("are supported by this server")
+
+// ============================================================================
+// STATS REPLIES (2xx)
+// ============================================================================
+#define RPL_STATSLINKINFO(nick, info) \
+    NumericReply(211, nick).arg(info)
+
+#define RPL_STATSCOMMANDS(nick, command, count, bytes) \
+    NumericReply(212, nick).arg(command).arg(count).arg(bytes).arg("0")
+
+#define RPL_ENDOFSTATS(nick, query) \
+    NumericReply(219, nick).arg(query).trailing("End of STATS report")
 
 // ============================================================================
 // CHANNEL REPLIES (3xx)
 // ============================================================================
 #define RPL_UMODEIS(nick, modes) \
-    (":" SERVER_NAME " 221 " + (nick) + " " + (modes))
+    NumericReply(221, nick).arg(modes)
 
 #define RPL_CHANNELMODEIS(nick, chan, modes, params) \
-    (":" SERVER_NAME " 324 " + (nick) + " " + (chan) + " " + (modes) + " " + (params))
+    NumericReply(324, nick).arg(chan).arg(modes).arg(params)
 
 #define RPL_NOTOPIC(nick, chan) \
-    (":" SERVER_NAME " 331 " + (nick) + " " + (chan) + " :No topic is set")
+    NumericReply(331, nick).arg(chan).trailing("No topic is set")
 
 #define RPL_TOPIC(nick, chan, topic) \
-    (":" SERVER_NAME " 332 " + (nick) + " " + (chan) + " :" + (topic))
+    NumericReply(332, nick).arg(chan).trailing(topic)
 
 #define RPL_INVITING(nick, target, chan) \
-    (":" SERVER_NAME " 341 " + (nick) + " " + (target) + " " + (chan))
+    NumericReply(341, nick).arg(target).arg(chan)
 
 #define RPL_NAMREPLY(nick, chan, names) \
-    (":" SERVER_NAME " 353 " + (nick) + " = " + (chan) + " :" + (names))
+    NumericReply(353, nick).arg("=").arg(chan).trailing(names)
 
 #define RPL_ENDOFNAMES(nick, chan) \
-    (":" SERVER_NAME " 366 " + (nick) + " " + (chan) + " :End of /NAMES list")
+    NumericReply(366, nick).arg(chan).trailing("End of /NAMES list")
 
 // ============================================================================
 // ERROR REPLIES (4xx)
 // ============================================================================
 #define ERR_NOSUCHNICK(nick, target) \
-    (":" SERVER_NAME " 401 " + (nick) + " " + (target) + " :No such nick/channel")
+    NumericReply(401, nick).arg(target).trailing("No such nick/channel")
 
 #define ERR_NOSUCHCHANNEL(nick, chan) \
-    (":" SERVER_NAME " 403 " + (nick) + " " + (chan) + " :No such channel")
+    NumericReply(403, nick).arg(chan).trailing("No such channel")
 
 #define ERR_CANNOTSENDTOCHAN(nick, chan) \
-    (":" SERVER_NAME " 404 " + (nick) + " " + (chan) + " :Cannot send to channel")
+    NumericReply(404, nick).arg(chan).trailing("Cannot send to channel")
+
+#define ERR_TOOMANYTARGETS(nick, target) \
+    NumericReply(407, nick).arg(target).trailing("Too many targets, only " STRINGIFY(MAX_TARGETS) " processed")
 
 #define ERR_TOOMANYCHANNELS(nick, chan) \
-    (":" SERVER_NAME " 405 " + (nick) + " " + (chan) + " :You have joined too many channels")
+    NumericReply(405, nick).arg(chan).trailing("You have joined too many channels")
 
 #define ERR_NOORIGIN(nick) \
-    (":" SERVER_NAME " 409 " + (nick) + " :No origin specified")
+    NumericReply(409, nick).trailing("No origin specified")
+
+#define ERR_INVALIDCAPCMD(nick, cmd) \
+    NumericReply(410, nick).arg(cmd).trailing("Invalid CAP command")
 
 #define ERR_NORECIPIENT(nick, cmd) \
-    (":" SERVER_NAME " 411 " + (nick) + " :No recipient given (" + (cmd) + ")")
+    NumericReply(411, nick).trailing("No recipient given (").append(cmd).append(")")
 
 #define ERR_NOTEXTTOSEND(nick) \
-    (":" SERVER_NAME " 412 " + (nick) + " :No text to send")
+    NumericReply(412, nick).trailing("No text to send")
+
+#define ERR_INPUTTOOLONG(nick) \
+    NumericReply(417, nick).trailing("Input line was too long")
 
 #define ERR_UNKNOWNCOMMAND(nick, cmd) \
-    (":" SERVER_NAME " 421 " + (nick) + " " + (cmd) + " :Unknown command")
+    NumericReply(421, nick).arg(cmd).trailing("Unknown command")
 
 #define ERR_NONICKNAMEGIVEN(nick) \
-    (":" SERVER_NAME " 431 " + (nick) + " :No nickname given")
+    NumericReply(431, nick).trailing("No nickname given")
 
 #define ERR_ERRONEUSNICKNAME(nick, badnick) \
-    (":" SERVER_NAME " 432 " + (nick) + " " + (badnick) + " :Erroneous nickname")
+    NumericReply(432, nick).arg(badnick).trailing("Erroneous nickname")
 
 #define ERR_NICKNAMEINUSE(nick) \
-    (":" SERVER_NAME " 433 * " + (nick) + " :Nickname is already in use")
+    NumericReply(433, "*").arg(nick).trailing("Nickname is already in use")
 
 #define ERR_USERNOTINCHANNEL(nick, target, chan) \
-    (":" SERVER_NAME " 441 " + (nick) + " " + (target) + " " + (chan) + " :They aren't on that channel")
+    NumericReply(441, nick).arg(target).arg(chan).trailing("They aren't on that channel")
 
 #define ERR_NOTONCHANNEL(nick, chan) \
-    (":" SERVER_NAME " 442 " + (nick) + " " + (chan) + " :You're not on that channel")
+    NumericReply(442, nick).arg(chan).trailing("You're not on that channel")
 
 #define ERR_USERONCHANNEL(nick, target, chan) \
-    (":" SERVER_NAME " 443 " + (nick) + " " + (target) + " " + (chan) + " :is already on channel")
+    NumericReply(443, nick).arg(target).arg(chan).trailing("is already on channel")
 
 #define ERR_NOTREGISTERED(nick) \
-    (":" SERVER_NAME " 451 " + (nick) + " :You have not registered")
+    NumericReply(451, nick).trailing("You have not registered")
 
 #define ERR_NEEDMOREPARAMS(nick, cmd) \
-    (":" SERVER_NAME " 461 " + (nick) + " " + (cmd) + " :Not enough parameters")
+    NumericReply(461, nick).arg(cmd).trailing("Not enough parameters")
 
 #define ERR_ALREADYREGISTERED(nick) \
-    (":" SERVER_NAME " 462 " + (nick) + " :You may not reregister")
+    NumericReply(462, nick).trailing("You may not reregister")
 
 #define ERR_PASSWDMISMATCH(nick) \
-    (":" SERVER_NAME " 464 " + (nick) + " :Password incorrect")
+    NumericReply(464, nick).trailing("Password incorrect")
 
 #define ERR_CHANNELISFULL(nick, chan) \
-    (":" SERVER_NAME " 471 " + (nick) + " " + (chan) + " :Cannot join channel (+l)")
+    NumericReply(471, nick).arg(chan).trailing("Cannot join channel (+l)")
 
 #define ERR_INVITEONLYCHAN(nick, chan) \
-    (":" SERVER_NAME " 473 " + (nick) + " " + (chan) + " :Cannot join channel (+i)")
+    NumericReply(473, nick).arg(chan).trailing("Cannot join channel (+i)")
 
 #define ERR_BANNEDFROMCHAN(nick, chan) \
-    (":" SERVER_NAME " 474 " + (nick) + " " + (chan) + " :Cannot join channel (+b)")
+    NumericReply(474, nick).arg(chan).trailing("Cannot join channel (+b)")
 
 #define ERR_BADCHANNELKEY(nick, chan) \
-    (":" SERVER_NAME " 475 " + (nick) + " " + (chan) + " :Cannot join channel (+k)")
+    NumericReply(475, nick).arg(chan).trailing("Cannot join channel (+k)")
 
 #define ERR_BADCHANMASK(nick, chan) \
-    (":" SERVER_NAME " 476 " + (nick) + " " + (chan) + " :Bad Channel Mask")
+    NumericReply(476, nick).arg(chan).trailing("Bad Channel Mask")
 
 #define ERR_UNKNOWNMODE(nick, mode) \
-    (":" SERVER_NAME " 472 " + (nick) + " " + (mode) + " :is unknown mode char to me")
+    NumericReply(472, nick).arg(mode).trailing("is unknown mode char to me")
 
 #define ERR_CHANOPRIVSNEEDED(nick, chan) \
-    (":" SERVER_NAME " 482 " + (nick) + " " + (chan) + " :You're not channel operator")
+    NumericReply(482, nick).arg(chan).trailing("You're not channel operator")
 
 #define ERR_INVALIDMODEPARAM(nick, chan, mode, param, reason) \
-    (":" SERVER_NAME " 696 " + (nick) + " " + (chan) + " " + (mode) + " " + (param) + " :" + (reason))
+    NumericReply(696, nick).arg(chan).arg(mode).arg(param).trailing(reason)
 
 // ============================================================================
 // PREFIX HELPER
@@ -0,0 +1,17 @@
+#ifndef SEARCHCOMMAND_HPP
+#define SEARCHCOMMAND_HPP
+
+#include "Command.hpp"
+
+class SearchCommand : public Command {
+private:
+    void fail(const char* code, const std::string& context, const char* description);
+
+public:
+    SearchCommand(Server* srv, Client* cli, const std::vector<std::string>& params);
+    ~SearchCommand();
+    
+    void execute();
+};
+
+#endif
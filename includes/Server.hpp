@@ -4,8 +4,15 @@
 #include <string>
 #include <map>
 #include <vector>
-#include <sys/select.h>
+#include <list>
+#include <sys/epoll.h>
 #include <unistd.h>
+#include "TimerWheel.hpp"
+#include "Config.hpp"
+#include "CaseFoldMap.hpp"
+#include "ConnectionThrottle.hpp"
+#include "BanTrie.hpp"
+#include "StringView.hpp"
 
 class Client;
 class Channel;
@@ -14,40 +21,79 @@ class Server {
 private:
     int port;
     std::string password;
+    Config config;
     int serverSocket;
+    int epollFd;
     bool    running;
     std::map<int, Client*> clients;
-    std::map<std::string, Channel*> channels;
+    CaseFoldMap<Client*> nicknames;
+    CaseFoldMap<Channel*> channels;
+    std::vector<int> pendingFlush;
+    std::vector<int> pendingEvictions;
+    unsigned long flushCount;
+    unsigned long flushedMessages;
+    unsigned long neighbourEpoch;
+    unsigned long historyIds;
+    unsigned long historyClockMs;
+    size_t historyBytes;
+    std::list<Channel*> historyLru;
+    TimerWheel timers;
+    ConnectionThrottle throttle;
+    BanTrie bans;
 
     int setupSocket();
-    void handleSelect();
-    int prepareSelectFds(fd_set& readfds);
+    int setupEpoll();
+    bool watchFd(int fd);
+    void unwatchFd(int fd);
+    bool setNonBlocking(int fd);
+    void updateInterest(Client* client);
+    void handleEvents();
+    int computeTimeout();
+    void runTimers();
+    void handleKeepalive(Client* client);
+    void pauseClient(Client* client);
+    void resumeClient(Client* client);
     void displayIdleAnimation();
-    void processReadyClients(fd_set& readfds);
+    void processReadyClients(struct epoll_event* events, int count);
     int gettingSocketReady();
     int setupBind();
     int  setupListen();
-    void acceptNewClient();
+    bool acceptNewClient();
+    void rejectConnection(int fd, const char* ip, const std::string& reason);
+    void loadBans();
+    void reloadBans();
     void handleClientMessage(int fd);
-    void executeCommand(Client* client, const std::string& cmd);
+    bool processClientLines(Client* client);
+    void handleClientWrite(int fd);
+    void flushPendingClients();
+    unsigned int executeCommand(Client* client, const StringView& line);
     
 public:
-    Server(int port, const std::string& password);
+    Server(int port, const std::string& password, const Config& config);
     ~Server();
     
     void start();
     void stop();
-    void disconnectClient(int fd);
+    void disconnectClient(int fd, const std::string& reason = "Client disconnected");
+    void closeLink(Client* client, const std::string& reason);
+    void scheduleFlush(Client* client);
+    void evictClient(Client* client);
     Channel* getOrCreateChannel(const std::string& name);
     void    removeChannel(const std::string& name);
-    std::string toLower(const std::string& str);
     bool    isValidName(const std::string& src) ;
     const std::string& getPassword();
+    void    completeRegistration(Client* client);
     void    broadcastQuitNotification(Client* client, const std::string& quitMsg);
-    std::vector<Channel*>   getClientChannels(Client* client);
+    void    broadcastToNeighbours(Client* client, const std::string& msg, bool includeSelf);
     Client* getClientByNick(const std::string& nick);
+    Client* getClientByNick(const StringView& nick);
+    void    updateNickIndex(Client* client, const std::string& oldNick);
     bool    channelExistOrNot(const std::string& name);
     Channel* getChannel(const std::string& name);
+    Channel* getChannel(const StringView& name);
+    void    recordHistory(Channel* channel, const std::string& line, const std::string& text);
+    void    touchHistory(Channel* channel);
+    void    forgetHistory(Channel* channel);
 };
 
 #endif
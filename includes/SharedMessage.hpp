@@ -0,0 +1,36 @@
+#ifndef SHAREDMESSAGE_HPP
+#define SHAREDMESSAGE_HPP
+
+#include <string>
+
+// Immutable, reference-counted wire line ("...\r\n"). A broadcast is
+// serialized once into a SharedMessage and the same buffer is queued on
+// every recipient; it is freed when the last send queue releases it.
+// Droppable messages (channel chatter) may be skipped for a congested
+// recipient instead of growing its queue.
+class SharedMessage {
+private:
+    std::string data;
+    int refCount;
+    bool droppable;
+
+    SharedMessage(const std::string& msg, bool droppable);
+    ~SharedMessage();
+    SharedMessage(const SharedMessage& other);
+    SharedMessage& operator=(const SharedMessage& other);
+
+public:
+    static SharedMessage* create(const std::string& msg, bool droppable = false);
+
+    void retain();
+    void release();
+    bool isShared() const;
+    bool isDroppable() const;
+
+    const std::string& getData() const;
+    size_t length() const;
+    void append(const std::string& msg);
+    void append(const char* msg, size_t len);
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef STATSCOMMAND_HPP
+#define STATSCOMMAND_HPP
+
+#include "Command.hpp"
+
+class StatsCommand : public Command {
+public:
+    StatsCommand(Server* srv, Client* cli, const std::vector<std::string>& params);
+    ~StatsCommand();
+    
+    void execute();
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef STRINGVIEW_HPP
+#define STRINGVIEW_HPP
+
+#include <string>
+#include <cstddef>
+
+// Non-owning (pointer, length) view into a buffer owned by someone else,
+// e.g. a line inside a client's input buffer. Only valid until that
+// buffer is modified.
+struct StringView {
+    const char* data;
+    size_t length;
+
+    StringView() : data(NULL), length(0) {}
+    StringView(const char* d, size_t len) : data(d), length(len) {}
+
+    bool empty() const { return length == 0; }
+    std::string str() const { return std::string(data, length); }
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <vector>
+#include <cstddef>
+
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS 4
+
+// Intrusive timer entry, embedded in its owner (e.g. a Client) so that
+// scheduling and cancelling never allocate. 'fd' identifies the owner
+// when the timer expires.
+struct TimerNode {
+    TimerNode* prev;
+    TimerNode* next;
+    unsigned long expires;
+    int fd;
+
+    TimerNode();
+    bool isScheduled() const;
+};
+
+// Hierarchical timing wheel (4 levels of 64 slots). Scheduling and
+// cancelling are O(1); timers far in the future sit in the coarse levels
+// and are cascaded down as the wheel turns. Time is counted in ticks.
+class TimerWheel {
+private:
+    TimerNode slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+    unsigned long current;
+    size_t count;
+
+    TimerWheel(const TimerWheel& other);
+    TimerWheel& operator=(const TimerWheel& other);
+
+    void link(TimerNode* node);
+    void unlink(TimerNode* node);
+    void cascade(int level, size_t index);
+
+public:
+    TimerWheel();
+    ~TimerWheel();
+
+    void reset(unsigned long now);
+    void schedule(TimerNode* node, unsigned long expires);
+    void cancel(TimerNode* node);
+    void advance(unsigned long now, std::vector<TimerNode*>& expired);
+    unsigned long ticksUntilNext() const;
+    unsigned long getCurrent() const;
+    size_t size() const;
+};
+
+#endif
@@ -1,10 +1,11 @@
 #include "includes/Server.hpp"
+#include "includes/Config.hpp"
 #include <iostream>
 #include <cstdlib>
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <port> <password>" << std::endl;
+    if (argc != 3 && argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <port> <password> [config file]" << std::endl;
         return 1;
     }
 
@@ -24,7 +25,10 @@ int main(int argc, char* argv[]) {
     std::string password = argv[2];
 
     try {
-        Server server(port, password);
+        Config config;
+        if (argc == 4)
+            config.load(argv[3]);
+        Server server(port, password, config);
         server.start();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
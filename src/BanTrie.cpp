@@ -0,0 +1,140 @@
+#include "../includes/BanTrie.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+BanTrie::Node::Node(const NetMask& prefix) : prefix(prefix), banned(false) {
+    child[0] = NULL;
+    child[1] = NULL;
+}
+
+BanTrie::BanTrie() : root(NULL), count(0) {
+}
+
+BanTrie::~BanTrie() {
+    destroy(root);
+}
+
+void BanTrie::destroy(Node* node) {
+    if (node == NULL)
+        return;
+    destroy(node->child[0]);
+    destroy(node->child[1]);
+    delete node;
+}
+
+// Number of leading bits a and b share, at most 'limit'.
+int BanTrie::commonBits(const NetMask& a, const NetMask& b, int limit) {
+    int bits = 0;
+    int i = 0;
+    while (bits + 8 <= limit && a.addr[i] == b.addr[i]) {
+        bits += 8;
+        i++;
+    }
+    while (bits < limit && a.bitAt(bits) == b.bitAt(bits))
+        bits++;
+    return bits;
+}
+
+// Adds (or re-words) the ban on 'prefix'. Nodes are only created where
+// two prefixes diverge, so the depth is bounded by the number of
+// distinct prefix lengths on a path rather than by 128.
+void BanTrie::insert(const NetMask& prefix, const std::string& reason) {
+    Node** link = &root;
+
+    while (*link != NULL) {
+        Node* node = *link;
+        int limit = node->prefix.bits < prefix.bits ? node->prefix.bits : prefix.bits;
+        int common = commonBits(node->prefix, prefix, limit);
+
+        if (common < node->prefix.bits) {
+            // The new prefix leaves (or ends inside) this node's prefix:
+            // hang both under a node for the part they share.
+            NetMask shared = prefix;
+            shared.truncate(common);
+            Node* split = new Node(shared);
+            split->child[node->prefix.bitAt(common)] = node;
+            *link = split;
+            if (common < prefix.bits)
+                link = &split->child[prefix.bitAt(common)];
+            break;
+        }
+        if (node->prefix.bits == prefix.bits)
+            break;
+        link = &node->child[prefix.bitAt(node->prefix.bits)];
+    }
+    if (*link == NULL)
+        *link = new Node(prefix);
+    if (!(*link)->banned)
+        count++;
+    (*link)->banned = true;
+    (*link)->reason = reason;
+}
+
+// Returns the reason of the most specific ban covering 'address', or
+// NULL when it is not banned.
+const std::string* BanTrie::match(const NetMask& address) const {
+    const Node* node = root;
+    const Node* best = NULL;
+
+    while (node != NULL && node->prefix.contains(address)) {
+        if (node->banned)
+            best = node;
+        if (node->prefix.bits >= address.bits)
+            break;
+        node = node->child[address.bitAt(node->prefix.bits)];
+    }
+    return best ? &best->reason : NULL;
+}
+
+// Bulk-loads a ban file: one address or prefix per line, optionally
+// followed by a reason; '#' starts a comment. Throws std::runtime_error
+// naming the first bad line.
+void BanTrie::loadFile(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file)
+        throw std::runtime_error("cannot open ban file '" + path + "'");
+
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(file, line)) {
+        lineNo++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line = line.substr(0, comment);
+        std::istringstream iss(line);
+        std::string mask, reason;
+        if (!(iss >> mask))
+            continue;
+        std::getline(iss >> std::ws, reason);
+        size_t end = reason.find_last_not_of(" \t\r");
+        reason = (end == std::string::npos) ? "Banned" : reason.substr(0, end + 1);
+
+        NetMask prefix;
+        if (!NetMask::parse(mask, prefix)) {
+            std::ostringstream oss;
+            oss << path << " line " << lineNo << ": invalid address mask '" << mask << "'";
+            throw std::runtime_error(oss.str());
+        }
+        insert(prefix, reason);
+    }
+}
+
+void BanTrie::swap(BanTrie& other) {
+    Node* tmpRoot = root;
+    size_t tmpCount = count;
+    root = other.root;
+    count = other.count;
+    other.root = tmpRoot;
+    other.count = tmpCount;
+}
+
+void BanTrie::clear() {
+    destroy(root);
+    root = NULL;
+    count = 0;
+}
+
+size_t BanTrie::size() const {
+    return count;
+}
@@ -0,0 +1,104 @@
+#include "../includes/CapCommand.hpp"
+#include "../includes/Server.hpp"
+#include "../includes/Client.hpp"
+#include "../includes/Replies.hpp"
+#include <sstream>
+#include <cctype>
+
+struct Capability {
+    const char* name;
+    unsigned int bit;
+};
+
+static const Capability capabilities[] = {
+    { "message-tags",      CAP_MESSAGE_TAGS },
+    { "batch",             CAP_BATCH },
+    { "server-time",       CAP_SERVER_TIME },
+    { "draft/chathistory", CAP_CHATHISTORY }
+};
+
+#define CAPABILITY_COUNT (sizeof(capabilities) / sizeof(capabilities[0]))
+
+static unsigned int findCapability(const std::string& name) {
+    for (size_t i = 0; i < CAPABILITY_COUNT; i++) {
+        if (name == capabilities[i].name)
+            return capabilities[i].bit;
+    }
+    return 0;
+}
+
+static std::string capabilityList(unsigned int mask) {
+    std::string list;
+    for (size_t i = 0; i < CAPABILITY_COUNT; i++) {
+        if (!(mask & capabilities[i].bit))
+            continue;
+        if (!list.empty())
+            list += ' ';
+        list += capabilities[i].name;
+    }
+    return list;
+}
+
+CapCommand::CapCommand(Server* srv, Client* cli, const std::vector<std::string>& params)
+    : Command(srv, cli, params) {
+}
+
+CapCommand::~CapCommand() {
+}
+
+void CapCommand::reply(const std::string& subcommand, const std::string& caps) {
+    std::string nick = client->getNickname().empty() ? "*" : client->getNickname();
+    client->sendMessage(":" SERVER_NAME " CAP " + nick + " " + subcommand + " :" + caps + "\r\n");
+}
+
+// CAP LS [version] | LIST | REQ :<caps> | END. Starting negotiation
+// before registration holds the welcome burst back until CAP END. A REQ
+// is applied all or nothing; "-name" disables a capability.
+void CapCommand::execute() {
+    std::string nick = client->getNickname().empty() ? "*" : client->getNickname();
+    if (params.empty()) {
+        client->sendReply(ERR_NEEDMOREPARAMS(nick, "CAP"));
+        return;
+    }
+
+    std::string subcommand = params[0];
+    for (size_t i = 0; i < subcommand.length(); i++)
+        subcommand[i] = std::toupper(static_cast<unsigned char>(subcommand[i]));
+
+    if (subcommand == "LS") {
+        if (!client->isRegistered())
+            client->setCapNegotiating(true);
+        reply("LS", capabilityList(~0U));
+    }
+    else if (subcommand == "LIST")
+        reply("LIST", capabilityList(client->getCaps()));
+    else if (subcommand == "REQ") {
+        if (!client->isRegistered())
+            client->setCapNegotiating(true);
+        std::string requested = params.size() > 1 ? params[1] : "";
+        if (!requested.empty() && requested[0] == ':')
+            requested.erase(0, 1);
+        std::istringstream iss(requested);
+        std::string name;
+        unsigned int caps = client->getCaps();
+        while (iss >> name) {
+            bool disable = (name[0] == '-');
+            unsigned int bit = findCapability(disable ? name.substr(1) : name);
+            if (bit == 0) {
+                reply("NAK", requested);
+                return;
+            }
+            caps = disable ? (caps & ~bit) : (caps | bit);
+        }
+        client->setCaps(caps);
+        reply("ACK", requested);
+    }
+    else if (subcommand == "END") {
+        if (client->isRegistered())
+            return;
+        client->setCapNegotiating(false);
+        server->completeRegistration(client);
+    }
+    else
+        client->sendReply(ERR_INVALIDCAPCMD(nick, params[0]));
+}
@@ -0,0 +1,83 @@
+#include "../includes/CaseMapping.hpp"
+#include <fstream>
+#include <ctime>
+#include <unistd.h>
+
+std::string ircCasefold(const std::string& str) {
+    std::string result = str;
+    for (size_t i = 0; i < result.length(); i++)
+        result[i] = ircToLower(static_cast<unsigned char>(result[i]));
+    return result;
+}
+
+bool ircEquals(const char* a, size_t aLen, const char* b, size_t bLen) {
+    if (aLen != bLen)
+        return false;
+    for (size_t i = 0; i < aLen; i++) {
+        if (ircToLower(static_cast<unsigned char>(a[i])) != ircToLower(static_cast<unsigned char>(b[i])))
+            return false;
+    }
+    return true;
+}
+
+static uint64_t g_hashKey[2];
+static bool g_hashKeyReady = false;
+
+static void initHashKey() {
+    std::ifstream urandom("/dev/urandom", std::ios::binary);
+    if (!urandom.read(reinterpret_cast<char*>(g_hashKey), sizeof(g_hashKey))) {
+        g_hashKey[0] = static_cast<uint64_t>(time(NULL)) * 0x9e3779b97f4a7c15ULL;
+        g_hashKey[1] = static_cast<uint64_t>(getpid()) * 0xc2b2ae3d27d4eb4fULL;
+    }
+    g_hashKeyReady = true;
+}
+
+#define ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define SIPROUND \
+    do { \
+        v0 += v1; v1 = ROTL(v1, 13); v1 ^= v0; v0 = ROTL(v0, 32); \
+        v2 += v3; v3 = ROTL(v3, 16); v3 ^= v2; \
+        v0 += v3; v3 = ROTL(v3, 21); v3 ^= v0; \
+        v2 += v1; v1 = ROTL(v1, 17); v1 ^= v2; v2 = ROTL(v2, 32); \
+    } while (0)
+
+static uint64_t sipHash(const char* data, size_t len, bool fold) {
+    if (!g_hashKeyReady)
+        initHashKey();
+
+    uint64_t v0 = 0x736f6d6570736575ULL ^ g_hashKey[0];
+    uint64_t v1 = 0x646f72616e646f6dULL ^ g_hashKey[1];
+    uint64_t v2 = 0x6c7967656e657261ULL ^ g_hashKey[0];
+    uint64_t v3 = 0x7465646279746573ULL ^ g_hashKey[1];
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+    size_t blocks = len / 8;
+
+    for (size_t i = 0; i < blocks; i++, in += 8) {
+        uint64_t m = 0;
+        for (int j = 0; j < 8; j++)
+            m |= static_cast<uint64_t>(fold ? ircToLower(in[j]) : in[j]) << (8 * j);
+        v3 ^= m;
+        SIPROUND;
+        v0 ^= m;
+    }
+    uint64_t last = static_cast<uint64_t>(len) << 56;
+    for (size_t j = 0; j < len % 8; j++)
+        last |= static_cast<uint64_t>(fold ? ircToLower(in[j]) : in[j]) << (8 * j);
+    v3 ^= last;
+    SIPROUND;
+    v0 ^= last;
+    v2 ^= 0xff;
+    SIPROUND;
+    SIPROUND;
+    SIPROUND;
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+uint64_t ircHash(const char* data, size_t len) {
+    return sipHash(data, len, true);
+}
+
+uint64_t keyedHash(const char* data, size_t len) {
+    return sipHash(data, len, false);
+}
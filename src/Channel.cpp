@@ -4,17 +4,20 @@
 #include "../includes/Client.hpp"
 #include "../includes/Command.hpp"
 #include "../includes/Replies.hpp"
+#include "../includes/SharedMessage.hpp"
+#include "../includes/CaseMapping.hpp"
 
 
 Channel::Channel(const std::string& name, Server* srv) 
-    : name(name), userLimit(0), inviteOnly(false), topicRestricted(false), server(srv) {
+    : name(name), foldedName(ircCasefold(name)), userLimit(0), operatorCount(0), inviteOnly(false),
+      topicRestricted(false), server(srv) {
         this->topic = "";
         this->key = "";
 }
 
 void Channel::clearAllSet() {
     members.clear();
-    operators.clear();
+    operatorCount = 0;
     invitedUsers.clear();
     topic.clear();
     key.clear();
@@ -24,25 +27,27 @@ Channel::~Channel() {
     clearAllSet();    
 }
 
-std::string Channel::getName() const {
+const std::string& Channel::getName() const {
     return name;
 }
 
-std::string Channel::getTopic() const {
+const std::string& Channel::getFoldedName() const {
+    return foldedName;
+}
+
+const std::string& Channel::getTopic() const {
     return topic;
 }
 
 void Channel::setTopic(const std::string& topic, Client* client) {
     if(topicRestricted == true) {
         if (!isOperator(client)) {
-            client->sendMessage(ERR_CHANOPRIVSNEEDED(client->getNickname(), name) + "\r\n");
+            client->sendReply(ERR_CHANOPRIVSNEEDED(client->getNickname(), name));
             return;
         }
     }
     this->topic = topic;
-    std::string msg = USER_PREFIX(client->getNickname(), 
-                                  client->getUsername(), "unknown.host") + 
-                      " TOPIC " + name + " :" + topic + "\r\n";
+    std::string msg = client->getPrefix() + " TOPIC " + name + " :" + topic + "\r\n";
     broadcast(msg, NULL);
 }
 
@@ -77,64 +82,107 @@ void Channel::addMember(Client* client) {
         return;
     
     if (isChannelFull()) {
-        client->sendMessage(ERR_CHANNELISFULL(client->getNickname(), name) + "\r\n");
+        client->sendReply(ERR_CHANNELISFULL(client->getNickname(), name));
         return;
     }
     
-    members.insert(client);
-    client->addToChannel(this);
+    Membership slot;
+    slot.client = client;
+    slot.modes = 0;
+    members.push_back(slot);
+    client->addToChannel(this, members.size() - 1);
     
     invitedUsers.erase(client);
-    if (getMembers().size() == 1) {
+    if (members.size() == 1) {
         addOperator(client);
     }
     if (topic.empty()) {
-        client->sendMessage(RPL_NOTOPIC(client->getNickname(), name) + "\r\n");
+        client->sendReply(RPL_NOTOPIC(client->getNickname(), name));
     }
     else {
-        client->sendMessage(RPL_TOPIC(client->getNickname(), name, topic) + "\r\n");
+        client->sendReply(RPL_TOPIC(client->getNickname(), name, topic));
     }
+    // Split the names over as many 353 lines as needed: the room left
+    // for names is what an empty 353 to this client leaves of the line.
+    const std::string& nick = client->getNickname();
+    size_t room = MAX_LINE_LENGTH - 2 - RPL_NAMREPLY(nick, name, "").length();
     std::string memmberList = "";
-    std::set<Client*>::iterator it;
-    for (it = members.begin() ; it != members.end() ; it++) {
+    for (size_t i = 0 ; i < members.size() ; i++) {
+        std::string entry = (members[i].modes & MEMBER_OP) ? "@" : "";
+        entry += members[i].client->getNickname();
+        if (!memmberList.empty() && memmberList.length() + 1 + entry.length() > room) {
+            client->sendReply(RPL_NAMREPLY(nick, name, memmberList));
+            memmberList.clear();
+        }
         if (!memmberList.empty())
             memmberList += " ";
-        if (operators.find(*it) != operators.end()) {
-            memmberList += "@";
-        }
-        memmberList += (*it)->getNickname();
+        memmberList += entry;
     }
-    client->sendMessage(RPL_NAMREPLY(client->getNickname(), name, memmberList) + "\r\n");
-    client->sendMessage(RPL_ENDOFNAMES(client->getNickname(), name) + "\r\n");
+    client->sendReply(RPL_NAMREPLY(nick, name, memmberList));
+    client->sendReply(RPL_ENDOFNAMES(nick, name));
 }
 
 void Channel::removeMember(Client* client) {
     if (!isMember(client))
         return;
     
-    members.erase(client);
-    operators.erase(client);      
+    detachMember(client);
+}
+
+Membership* Channel::findMember(Client* client) {
+    if (client == NULL)
+        return (NULL);
+    size_t slot = client->getChannelSlot(this);
+    if (slot == NO_CHANNEL_SLOT)
+        return (NULL);
+    return (&members[slot]);
+}
+
+const Membership* Channel::findMember(Client* client) const {
+    return (const_cast<Channel*>(this)->findMember(client));
+}
+
+// Drops client's slot by moving the last slot into its place, then
+// hands the operator role on if it was the last one. Returns false when
+// the channel became empty and was destroyed; `this` is gone then.
+bool Channel::detachMember(Client* client) {
+    size_t slot = client->getChannelSlot(this);
+
+    if (members[slot].modes & MEMBER_OP)
+        operatorCount--;
+    if (slot != members.size() - 1) {
+        members[slot] = members.back();
+        members[slot].client->setChannelSlot(this, slot);
+    }
+    members.pop_back();
     invitedUsers.erase(client);
     client->removeFromChannel(this);
+
     if (members.empty() && server != NULL) {
         server->removeChannel(getName());
-        return;
+        return (false);
     }
-    if (operators.empty() && !members.empty()) {
-        Client* newOp = *(members.begin());
-        operators.insert(newOp);
+    if (operatorCount == 0 && !members.empty()) {
+        Client* newOp = members[0].client;
+        members[0].modes |= MEMBER_OP;
+        operatorCount++;
         std::string msg = ":" SERVER_NAME " MODE " + name + " +o " + 
                           newOp->getNickname() + "\r\n";
         broadcast(msg, NULL);
     }
+    return (true);
 }
 
 void Channel::addOperator(Client* target, Client* setter) {
-    if (!isMember(target)) {
+    Membership* member = findMember(target);
+    if (member == NULL) {
         return;
     }
 
-    operators.insert(target);
+    if (!(member->modes & MEMBER_OP)) {
+        member->modes |= MEMBER_OP;
+        operatorCount++;
+    }
     std::string msg;
     if (setter != NULL) {
         msg = setter->getPrefix() + " MODE " + name + " +o " + 
@@ -151,14 +199,15 @@ void Channel::removeOperator(Client* target, Client* setter) {
         return;
     }
     
-    if (operators.size() == 1) {
+    if (operatorCount == 1) {
         std::string notice = ":" SERVER_NAME " NOTICE " + target->getNickname() + 
                            " :Cannot remove last operator from " + name + "\r\n";
         target->sendMessage(notice);
         return;
     }
     
-    operators.erase(target);
+    findMember(target)->modes &= ~MEMBER_OP;
+    operatorCount--;
     
     std::string msg;
     if (setter != NULL) {
@@ -172,23 +221,30 @@ void Channel::removeOperator(Client* target, Client* setter) {
 }
 
 bool Channel::isOperator(Client* client) const {
-    if (operators.find(client) != operators.end())
+    const Membership* member = findMember(client);
+    if (member != NULL && (member->modes & MEMBER_OP))
         return (true);
     return (false);
 }
 
 bool Channel::isMember(Client* client) const {
-    if (members.find(client) != members.end())
+    if (findMember(client) != NULL)
         return (true);
     return (false);
 }
 
-void Channel::broadcast(const std::string& msg, Client* exclude) {
-    std::set<Client*>::iterator it;
+void Channel::broadcast(const std::string& msg, Client* exclude, bool droppable) {
+    if (msg.empty())
+        return;
+    SharedMessage* shared = SharedMessage::create(msg, droppable);
+    broadcast(shared, exclude);
+    shared->release();
+}
 
-    for (it = members.begin() ; it != members.end() ; it++) {
-        Client* client = (*it);
-        if (client == NULL || client == exclude)
+void Channel::broadcast(SharedMessage* msg, Client* exclude) {
+    for (size_t i = 0 ; i < members.size() ; i++) {
+        Client* client = members[i].client;
+        if (client == exclude)
             continue;
         int fd = client->getFd();
         if (fd < 0) {
@@ -232,6 +288,10 @@ bool Channel::isChannelFull() const {
         return (false);
 }
 
+ChannelHistory& Channel::getHistory() {
+    return (history);
+}
+
 size_t Channel::getMembersCount() const {
     return (members.size());
 }
@@ -258,42 +318,24 @@ void Channel::kickMember(Client* kicker, Client* client, const std::string& reas
     }
 
     if (!isOperator(kicker)) {
-        kicker->sendMessage(ERR_CHANOPRIVSNEEDED(kicker->getNickname(), name) + "\r\n");
+        kicker->sendReply(ERR_CHANOPRIVSNEEDED(kicker->getNickname(), name));
         return;
     }
 
     if (!isMember(client)) {
-        kicker->sendMessage(ERR_USERNOTINCHANNEL(kicker->getNickname(), 
-                                                 client->getNickname(), name) + "\r\n");
+        kicker->sendReply(ERR_USERNOTINCHANNEL(kicker->getNickname(), 
+                                                 client->getNickname(), name));
         return;
     }
     
-    std::string kickMsg = USER_PREFIX(kicker->getNickname(), 
-                                      kicker->getUsername(), "unknown.host") + 
-                          " KICK " + name + " " + client->getNickname() + 
+    std::string kickMsg = kicker->getPrefix() + " KICK " + name + " " + client->getNickname() + 
                           " :" + reason + "\r\n";
     
     broadcast(kickMsg, NULL);
-
-    members.erase(client);
-    operators.erase(client);
-    invitedUsers.erase(client);
-    client->removeFromChannel(this);
-    
-    if (members.empty() && server != NULL) {
-        server->removeChannel(getName());
-        return;
-    }
-    if (operators.empty() && !members.empty()) {
-        Client* newOp = *(members.begin());
-        operators.insert(newOp);
-        std::string msg = ":" SERVER_NAME " MODE " + name + " +o " + 
-                          newOp->getNickname() + "\r\n";
-        broadcast(msg, NULL);
-    }
+    detachMember(client);
 }
 
-std::set<Client*> Channel::getMembers() const {
+const std::vector<Membership>& Channel::getMembers() const {
     return (members);
 }
 
@@ -0,0 +1,213 @@
+#include "../includes/ChannelHistory.hpp"
+#include "../includes/Client.hpp"
+#include "../includes/SharedMessage.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+ChannelHistory::ChannelHistory() : start(0), count(0), bytes(0), listed(false) {
+}
+
+ChannelHistory::~ChannelHistory() {
+    clear();
+}
+
+const ChannelHistory::Entry& ChannelHistory::at(size_t pos) const {
+    return ring[(start + pos) % ring.size()];
+}
+
+unsigned long ChannelHistory::keyAt(size_t pos, bool byId) const {
+    return byId ? at(pos).id : at(pos).timeMs;
+}
+
+// Stores line (taking a reference) as the newest entry and indexes its
+// text, dropping the oldest entry once the ring holds 'capacity' lines.
+// The ring only grows as lines arrive, so quiet channels never pay for
+// a full one.
+void ChannelHistory::append(unsigned long id, unsigned long timeMs, SharedMessage* line,
+                            const std::string& text, size_t capacity) {
+    if (count >= capacity)
+        dropOldest();
+    if (count >= capacity)
+        return;
+
+    Entry entry;
+    entry.id = id;
+    entry.timeMs = timeMs;
+    entry.line = line;
+    entry.postings = index.add(id, text);
+    if (count == ring.size()) {
+        std::rotate(ring.begin(), ring.begin() + start, ring.end());
+        start = 0;
+        ring.push_back(entry);
+    }
+    else
+        ring[(start + count) % ring.size()] = entry;
+    line->retain();
+    count++;
+    bytes += line->length() + sizeof(Entry);
+}
+
+void ChannelHistory::dropOldest() {
+    if (count == 0)
+        return;
+    Entry& oldest = ring[start];
+    bytes -= oldest.line->length() + sizeof(Entry);
+    oldest.line->release();
+    oldest.line = NULL;
+    start = (start + 1) % ring.size();
+    count--;
+    index.retire(oldest.postings, count > 0 ? at(0).id : oldest.id + 1);
+}
+
+void ChannelHistory::clear() {
+    for (size_t pos = 0; pos < count; pos++)
+        at(pos).line->release();
+    std::vector<Entry>().swap(ring);
+    index.clear();
+    start = 0;
+    count = 0;
+    bytes = 0;
+}
+
+size_t ChannelHistory::size() const {
+    return count;
+}
+
+size_t ChannelHistory::getBytes() const {
+    return bytes + index.getBytes();
+}
+
+// Number of stored lines strictly older than ref. Message ids and
+// timestamps both only grow along the ring, so this is a binary search.
+size_t ChannelHistory::countBefore(const HistoryRef& ref) const {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (keyAt(mid, ref.byId) < ref.value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Number of stored lines older than or at ref.
+size_t ChannelHistory::countUpTo(const HistoryRef& ref) const {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (keyAt(mid, ref.byId) <= ref.value)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+// Queues positions [first, last) on client, oldest first; without
+// 'tagged' each line is sent from just past its tag prefix.
+void ChannelHistory::replay(Client* client, size_t first, size_t last, bool tagged) const {
+    for (size_t pos = first; pos < last && pos < count; pos++) {
+        if (tagged) {
+            client->sendMessage(at(pos).line);
+            continue;
+        }
+        const std::string& data = at(pos).line->getData();
+        size_t body = data.find(' ') + 1;
+        client->sendMessage(data.data() + body, data.length() - body);
+    }
+}
+
+// Fills positions, oldest first, with the newest 'limit' stored lines
+// containing every word of query.
+void ChannelHistory::search(const std::string& query, size_t limit,
+                            std::vector<size_t>& positions) const {
+    std::vector<unsigned long> ids;
+
+    positions.clear();
+    if (count == 0)
+        return;
+    index.search(query, at(0).id, ids);
+    size_t first = ids.size() > limit ? ids.size() - limit : 0;
+    for (size_t i = first; i < ids.size(); i++) {
+        HistoryRef ref;
+        ref.byId = true;
+        ref.value = ids[i];
+        positions.push_back(countBefore(ref));
+    }
+}
+
+bool ChannelHistory::isListed() const {
+    return listed;
+}
+
+std::list<Channel*>::iterator ChannelHistory::getLruPosition() const {
+    return lruPos;
+}
+
+void ChannelHistory::setLruPosition(std::list<Channel*>::iterator pos) {
+    lruPos = pos;
+    listed = true;
+}
+
+void ChannelHistory::unlist() {
+    listed = false;
+}
+
+// "2026-10-18T00:27:20.123Z", as used by the IRCv3 server-time tag.
+std::string ChannelHistory::formatTime(unsigned long timeMs) {
+    time_t seconds = static_cast<time_t>(timeMs / 1000);
+    struct tm utc;
+    char buffer[32];
+
+    gmtime_r(&seconds, &utc);
+    size_t len = strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(buffer + len, sizeof(buffer) - len, ".%03luZ", timeMs % 1000);
+    return buffer;
+}
+
+bool ChannelHistory::parseRef(const std::string& str, HistoryRef& ref) {
+    if (str.compare(0, 6, "msgid=") == 0) {
+        const char* digits = str.c_str() + 6;
+        char* end;
+        if (*digits < '0' || *digits > '9')
+            return false;
+        ref.byId = true;
+        ref.value = std::strtoul(digits, &end, 10);
+        return *end == '\0';
+    }
+    if (str.compare(0, 10, "timestamp=") == 0) {
+        struct tm utc;
+        int millis = 0;
+        int consumed = 0;
+        const char* stamp = str.c_str() + 10;
+
+        std::memset(&utc, 0, sizeof(utc));
+        if (sscanf(stamp, "%4d-%2d-%2dT%2d:%2d:%2d%n", &utc.tm_year, &utc.tm_mon,
+                   &utc.tm_mday, &utc.tm_hour, &utc.tm_min, &utc.tm_sec, &consumed) != 6)
+            return false;
+        stamp += consumed;
+        if (*stamp == '.') {
+            consumed = 0;
+            if (sscanf(stamp, ".%3d%n", &millis, &consumed) != 1 || consumed != 4)
+                return false;
+            stamp += consumed;
+        }
+        if (std::string(stamp) != "Z")
+            return false;
+        utc.tm_year -= 1900;
+        utc.tm_mon -= 1;
+        time_t seconds = timegm(&utc);
+        if (seconds < 0)
+            return false;
+        ref.byId = false;
+        ref.value = static_cast<unsigned long>(seconds) * 1000 + millis;
+        return true;
+    }
+    return false;
+}
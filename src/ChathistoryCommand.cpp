@@ -0,0 +1,94 @@
+#include "../includes/ChathistoryCommand.hpp"
+#include "../includes/Server.hpp"
+#include "../includes/Client.hpp"
+#include "../includes/Channel.hpp"
+#include "../includes/Replies.hpp"
+#include <cstdlib>
+#include <cctype>
+
+ChathistoryCommand::ChathistoryCommand(Server* srv, Client* cli, const std::vector<std::string>& params)
+    : Command(srv, cli, params) {
+}
+
+ChathistoryCommand::~ChathistoryCommand() {
+}
+
+// IRCv3 standard reply: "FAIL CHATHISTORY <code> <context> :<description>".
+void ChathistoryCommand::fail(const char* code, const std::string& context, const char* description) {
+    client->sendMessage(":" SERVER_NAME " FAIL CHATHISTORY " + std::string(code) + " "
+                        + context + " :" + description + "\r\n");
+}
+
+// CHATHISTORY LATEST <channel> <* | reference> <limit>
+// CHATHISTORY BEFORE <channel> <reference> <limit>
+// CHATHISTORY AFTER <channel> <reference> <limit>
+// A reference is msgid=<id> or timestamp=<YYYY-MM-DDThh:mm:ss.sssZ>. At
+// most HISTORY_REPLAY_MAX lines come back, oldest first. Clients that
+// enabled message-tags and batch get them tagged inside a "chathistory"
+// batch; everyone else gets the plain lines.
+void ChathistoryCommand::execute() {
+    if (!client->isRegistered()) {
+        client->sendReply(ERR_NOTREGISTERED(client->getNickname()));
+        return;
+    }
+    if (params.size() < 4) {
+        client->sendReply(ERR_NEEDMOREPARAMS(client->getNickname(), "CHATHISTORY"));
+        return;
+    }
+
+    std::string subcommand = params[0];
+    for (size_t i = 0; i < subcommand.length(); i++)
+        subcommand[i] = std::toupper(static_cast<unsigned char>(subcommand[i]));
+    if (subcommand != "LATEST" && subcommand != "BEFORE" && subcommand != "AFTER") {
+        fail("UNKNOWN_COMMAND", params[0], "Unknown subcommand");
+        return;
+    }
+
+    const std::string& target = params[1];
+    Channel* channel = server->getChannel(target);
+    if (channel == NULL || !channel->isMember(client)) {
+        fail("INVALID_TARGET", subcommand + " " + target, "Messages could not be retrieved");
+        return;
+    }
+
+    HistoryRef ref;
+    bool anchored = !(subcommand == "LATEST" && params[2] == "*");
+    if (anchored && !ChannelHistory::parseRef(params[2], ref)) {
+        fail("INVALID_PARAMS", subcommand + " " + params[2], "Invalid message reference");
+        return;
+    }
+    char* end;
+    unsigned long limit = std::strtoul(params[3].c_str(), &end, 10);
+    if (params[3].empty() || *end != '\0' || limit == 0) {
+        fail("INVALID_PARAMS", subcommand + " " + params[3], "Invalid limit");
+        return;
+    }
+    if (limit > HISTORY_REPLAY_MAX)
+        limit = HISTORY_REPLAY_MAX;
+
+    ChannelHistory& history = channel->getHistory();
+    size_t first;
+    size_t last;
+    if (subcommand == "BEFORE") {
+        last = history.countBefore(ref);
+        first = last > limit ? last - limit : 0;
+    }
+    else if (subcommand == "AFTER") {
+        first = history.countUpTo(ref);
+        last = first + limit;
+    }
+    else {
+        last = history.size();
+        first = last > limit ? last - limit : 0;
+        if (anchored && history.countUpTo(ref) > first)
+            first = history.countUpTo(ref);
+    }
+
+    bool tagged = client->hasCaps(CAP_MESSAGE_TAGS | CAP_BATCH);
+    if (tagged)
+        client->sendMessage(":" SERVER_NAME " BATCH +" HISTORY_BATCH " chathistory " + channel->getName() + "\r\n");
+    history.replay(client, first, last, tagged);
+    if (tagged)
+        client->sendMessage(":" SERVER_NAME " BATCH -" HISTORY_BATCH "\r\n");
+    server->touchHistory(channel);
+}
@@ -1,29 +1,49 @@
 
 #include "../includes/Client.hpp"
 #include "../includes/Channel.hpp"
+#include "../includes/Server.hpp"
+#include "../includes/SharedMessage.hpp"
+#include "../includes/Config.hpp"
+#include "../includes/NumericReply.hpp"
+#include "../includes/Replies.hpp"
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
+#if defined(__SSE2__) || defined(__AVX2__)
+# include <immintrin.h>
+#endif
 
-Client::Client(int fd) 
-    : fd(fd), authenticated(false), registered(false) {
+Client::Client(int fd, Server* srv) 
+    : fd(fd), sourceCounted(false), authenticated(false), registered(false), caps(0), capNegotiating(false),
+      inStart(0), inScanned(0), inEnd(0), inDiscarding(false), sendOffset(0), writeWatched(false),
+      flushScheduled(false), queuedSinceFlush(0), sendQueueBytes(0), congested(false),
+      sendqExceeded(false), connectionClass(NULL), messagesQueued(0), droppedMessages(0),
+      bytesSent(0), linesReceived(0), bytesReceived(0), connectedAt(time(NULL)), server(srv),
+      lastActivity(0), awaitingPong(false), neighbourMark(0), floodClock(0), readPaused(false) {
         this->hostname = "unknown.host";
+        this->keepaliveTimer.fd = fd;
+        this->floodTimer.fd = fd;
+        rebuildPrefix();
 }
 
 Client::~Client() {
     channels.clear();
-    buffer.clear();
+    for (size_t i = 0; i < sendQueue.size(); i++)
+        sendQueue[i]->release();
+    sendQueue.clear();
 }
 
 int Client::getFd() const {
     return fd;
 }
 
-std::string Client::getRealname() const {
+const std::string& Client::getRealname() const {
     return realname;
 }
 
-std::string Client::getHostname() const {
+const std::string& Client::getHostname() const {
     return hostname;
 }
 
@@ -33,21 +53,35 @@ void Client::setRealname(const std::string& real) {
 
 void Client::setHostname(const std::string& host) {
     this->hostname = host;
+    rebuildPrefix();
 }
 
-std::string Client::getNickname() const {
+const std::string& Client::getNickname() const {
     return nickname;
 }
 
-std::string Client::getUsername() const {
+const std::string& Client::getUsername() const {
     return username;
 }
 
-std::string Client::getPrefix() const {
-    return ":" + nickname + "!" + username + "@" + hostname;
+// The ":nick!user@host" source of every message this client originates,
+// cached so broadcasts don't rebuild it; refreshed by the setters.
+const std::string& Client::getPrefix() const {
+    return prefix;
 }
 
-std::set<Channel*> Client::getChannels() const {
+void Client::rebuildPrefix() {
+    prefix.clear();
+    prefix.reserve(nickname.size() + username.size() + hostname.size() + 3);
+    prefix += ':';
+    prefix += nickname;
+    prefix += '!';
+    prefix += username;
+    prefix += '@';
+    prefix += hostname;
+}
+
+const std::map<Channel*, size_t>& Client::getChannels() const {
     return channels;
 }
 
@@ -74,10 +108,12 @@ void Client::setNickname(const std::string& nick) {
         }
     }
     this->nickname = nick;
+    rebuildPrefix();
 }
 
 void Client::setUsername(const std::string& user) {
     this->username = user;
+    rebuildPrefix();
 }
 
 void Client::authenticate() {
@@ -92,68 +128,440 @@ void Client::registerClient() {
     this->registered = true;
 }
 
-void Client::addToChannel(Channel* channel) {
+bool Client::hasCaps(unsigned int mask) const {
+    return (caps & mask) == mask;
+}
+
+unsigned int Client::getCaps() const {
+    return caps;
+}
+
+void Client::setCaps(unsigned int caps) {
+    this->caps = caps;
+}
+
+bool Client::isCapNegotiating() const {
+    return capNegotiating;
+}
+
+void Client::setCapNegotiating(bool negotiating) {
+    this->capNegotiating = negotiating;
+}
+
+void Client::addToChannel(Channel* channel, size_t slot) {
     if (!channel)
         return;
-    channels.insert(channel);
+    channels[channel] = slot;
 }
 
 void Client::removeFromChannel(Channel* channel) {
-    if (!channel || channels.find(channel) == channels.end())
+    if (!channel)
         return;
     channels.erase(channel);
 }
 
-void Client::appendToBuffer(const std::string& data) {
-    const size_t MAX_BUFFER_SIZE = 1024;
-    
-    if (buffer.length() + data.length() > MAX_BUFFER_SIZE) {
-        buffer.clear();
-        return;
+// Index of this client's entry in channel's member table, or
+// NO_CHANNEL_SLOT when it is not a member.
+size_t Client::getChannelSlot(Channel* channel) const {
+    std::map<Channel*, size_t>::const_iterator it = channels.find(channel);
+    if (it == channels.end())
+        return (NO_CHANNEL_SLOT);
+    return (it->second);
+}
+
+void Client::setChannelSlot(Channel* channel, size_t slot) {
+    channels[channel] = slot;
+}
+
+// Returns the first '\n' in [p, end), or NULL. Uses AVX2/SSE2 when the
+// build enables them, 32/16 bytes per compare, with a scalar tail.
+static const char* findLineFeed(const char* p, const char* end) {
+#if defined(__AVX2__)
+    const __m256i lf32 = _mm256_set1_epi8('\n');
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lf32));
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i lf16 = _mm_set1_epi8('\n');
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf16));
+        if (mask != 0)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == '\n')
+            return p;
+    }
+    return NULL;
+}
+
+// Hands out the free tail of the input buffer for recv() to write into.
+// Consumed bytes are reclaimed by moving the pending partial line to the
+// front, which happens at most once per buffer's worth of input. A buffer
+// filled by a single unterminated line is dropped, and so is the rest of
+// that line up to its LF: it must not be framed as new commands.
+size_t Client::prepareRead(char*& dst) {
+    if (inStart == inEnd) {
+        inStart = 0;
+        inScanned = 0;
+        inEnd = 0;
+    }
+    else if (inEnd == INPUT_BUFFER_SIZE) {
+        if (inStart == 0) {
+            if (!inDiscarding)
+                sendReply(ERR_INPUTTOOLONG(nickname.empty() ? "*" : nickname));
+            inDiscarding = true;
+            inScanned = 0;
+            inEnd = 0;
+        }
+        else {
+            std::memmove(inBuffer, inBuffer + inStart, inEnd - inStart);
+            inScanned -= inStart;
+            inEnd -= inStart;
+            inStart = 0;
+        }
+    }
+    dst = inBuffer + inEnd;
+    return INPUT_BUFFER_SIZE - inEnd;
+}
+
+void Client::commitRead(size_t len) {
+    inEnd += len;
+    bytesReceived += len;
+}
+
+// Yields the next CRLF-terminated line (without the CRLF) as a view into
+// the input buffer. The view stays valid until the next prepareRead().
+bool Client::extractLine(StringView& line) {
+    while (inScanned < inEnd) {
+        const char* lf = findLineFeed(inBuffer + inScanned, inBuffer + inEnd);
+        if (lf == NULL) {
+            inScanned = inEnd;
+            if (inDiscarding)
+                inStart = inEnd;
+            return false;
+        }
+        size_t pos = lf - inBuffer;
+        inScanned = pos + 1;
+        if (inDiscarding) {
+            inStart = inScanned;
+            inDiscarding = false;
+            continue;
+        }
+        if (pos > inStart && inBuffer[pos - 1] == '\r') {
+            line = StringView(inBuffer + inStart, pos - 1 - inStart);
+            inStart = inScanned;
+            linesReceived++;
+            return true;
+        }
     }
-    buffer.append(data);
+    return false;
 }
 
-std::string Client::extractCommand() {
-    size_t pos = buffer.find("\r\n");
-    
-    if (pos == std::string::npos) {
-        return "";
+// Enforces the connection class SendQ: droppable traffic is skipped
+// while the queue sits between the high and low watermarks, and going
+// over sendq_max gets the client evicted at the end of the loop iteration.
+bool Client::admitOutput(size_t len, bool droppable) {
+    if (sendqExceeded)
+        return false;
+    if (connectionClass == NULL)
+        return true;
+    if (droppable && congested) {
+        droppedMessages++;
+        return false;
     }
-    
-    std::string command = buffer.substr(0, pos);
-    buffer.erase(0, pos + 2);
-    
-    return command;
+    if (sendQueueBytes + len > connectionClass->sendqMax) {
+        sendqExceeded = true;
+        if (server != NULL)
+            server->evictClient(this);
+        return false;
+    }
+    return true;
+}
+
+void Client::accountQueued(size_t len) {
+    sendQueueBytes += len;
+    messagesQueued++;
+    queuedSinceFlush++;
+    if (connectionClass != NULL && connectionClass->dropLowPriority
+        && sendQueueBytes >= connectionClass->sendqHigh)
+        congested = true;
+    if (server != NULL)
+        server->scheduleFlush(this);
 }
 
 void Client::sendMessage(const std::string& msg) {
-    if (msg.empty())
+    sendMessage(msg.data(), msg.length());
+}
+
+void Client::sendMessage(const char* msg, size_t len) {
+    const size_t MAX_COALESCE_SIZE = 4096;
+
+    if (len == 0 || !admitOutput(len + 2, false))
         return;
 
-    std::string toSend = msg;
-    
-    if (toSend.length() < 2 || toSend.substr(toSend.length() - 2) != "\r\n") {
-        toSend += "\r\n";
+    // Replies for this client alone go into the private tail buffer when
+    // there is one, instead of allocating a new buffer per line.
+    size_t added;
+    if (!sendQueue.empty() && !sendQueue.back()->isShared()
+        && sendQueue.back()->length() + len <= MAX_COALESCE_SIZE) {
+        size_t before = sendQueue.back()->length();
+        sendQueue.back()->append(msg, len);
+        added = sendQueue.back()->length() - before;
     }
+    else {
+        sendQueue.push_back(SharedMessage::create(std::string(msg, len)));
+        added = sendQueue.back()->length();
+    }
+    accountQueued(added);
+}
 
-    size_t totalSent = 0;
-    size_t remaining = toSend.length();
+void Client::sendReply(const NumericReply& reply) {
+    sendMessage(reply.data(), reply.length());
+}
+
+void Client::sendMessage(SharedMessage* msg) {
+    if (msg == NULL || msg->length() == 0 || !admitOutput(msg->length(), msg->isDroppable()))
+        return;
 
-    int retryCount = 0;
-    const int MAX_RETRIES = 10;
-    
-    while (totalSent < toSend.length()) {
-        ssize_t sent = send(fd, toSend.c_str() + totalSent, remaining, 0);
-        
+    msg->retain();
+    sendQueue.push_back(msg);
+    accountQueued(msg->length());
+}
+
+bool Client::hasPendingOutput() const {
+    return !sendQueue.empty();
+}
+
+// Writes as much of the queue as the socket accepts without blocking,
+// gathering queued buffers into one sendmsg() call at a time.
+// Returns -1 when the connection is broken and must be dropped.
+int Client::flushOutput() {
+    const size_t MAX_IOV = 64;
+    struct iovec iov[MAX_IOV];
+
+    queuedSinceFlush = 0;
+    while (!sendQueue.empty()) {
+        size_t count = 0;
+        size_t requested = 0;
+        for (std::deque<SharedMessage*>::iterator it = sendQueue.begin();
+             it != sendQueue.end() && count < MAX_IOV; ++it, ++count) {
+            const std::string& data = (*it)->getData();
+            size_t offset = (count == 0) ? sendOffset : 0;
+            iov[count].iov_base = const_cast<char*>(data.data()) + offset;
+            iov[count].iov_len = data.length() - offset;
+            requested += iov[count].iov_len;
+        }
+
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
         if (sent < 0) {
-            if (++retryCount >= MAX_RETRIES) {
-                std::cerr << "Error: max retries reached for client " << fd << std::endl;
-                return;
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            std::cerr << "Error: failed to send to client " << fd << std::endl;
+            return (-1);
+        }
+
+        bytesSent += sent;
+        sendQueueBytes -= sent;
+        if (congested && connectionClass != NULL && sendQueueBytes <= connectionClass->sendqLow)
+            congested = false;
+
+        size_t remaining = sent;
+        while (remaining > 0) {
+            size_t left = sendQueue.front()->length() - sendOffset;
+            if (remaining < left) {
+                sendOffset += remaining;
+                break;
             }
-            continue;
+            remaining -= left;
+            sendQueue.front()->release();
+            sendQueue.pop_front();
+            sendOffset = 0;
         }
-        totalSent += sent;
-        remaining -= sent;
+        if (static_cast<size_t>(sent) < requested)
+            break;
+    }
+    return (0);
+}
+
+bool Client::isSendqExceeded() const {
+    return sendqExceeded;
+}
+
+// Drops everything still queued and writes 'last' straight to the socket,
+// best effort and without blocking. Used on the way out once the queue
+// itself no longer accepts output (sendq_max was hit). A line cut off
+// mid-write is terminated first so 'last' arrives on a line of its own.
+void Client::abortOutput(const std::string& last) {
+    std::string out;
+    if (sendOffset > 0 && sendQueue.front()->getData()[sendOffset - 1] != '\n')
+        out = "\r\n";
+    out += last;
+    while (!sendQueue.empty()) {
+        sendQueue.front()->release();
+        sendQueue.pop_front();
     }
+    sendOffset = 0;
+    sendQueueBytes = 0;
+    ssize_t sent = send(fd, out.data(), out.length(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent > 0)
+        bytesSent += sent;
+}
+
+bool Client::isWriteWatched() const {
+    return writeWatched;
+}
+
+void Client::setWriteWatched(bool watched) {
+    this->writeWatched = watched;
+}
+
+bool Client::isFlushScheduled() const {
+    return flushScheduled;
+}
+
+void Client::setFlushScheduled(bool scheduled) {
+    this->flushScheduled = scheduled;
+}
+
+size_t Client::getQueuedSinceFlush() const {
+    return queuedSinceFlush;
+}
+
+TimerNode* Client::getKeepaliveTimer() {
+    return &keepaliveTimer;
+}
+
+// Any data received from the client proves the link is alive.
+void Client::touch(unsigned long tick) {
+    this->lastActivity = tick;
+    this->awaitingPong = false;
+}
+
+unsigned long Client::getLastActivity() const {
+    return lastActivity;
+}
+
+bool Client::isAwaitingPong() const {
+    return awaitingPong;
+}
+
+void Client::setAwaitingPong(bool awaiting) {
+    this->awaitingPong = awaiting;
+}
+
+// Stamps the client for the given Server::broadcastToNeighbours pass;
+// false when it was already stamped (already has its copy).
+bool Client::markNeighbour(unsigned long epoch) {
+    if (neighbourMark == epoch)
+        return false;
+    neighbourMark = epoch;
+    return true;
+}
+
+TimerNode* Client::getFloodTimer() {
+    return &floodTimer;
+}
+
+// Fake lag: every command pushes floodClock forward by its cost, and
+// floodClock never lags behind real time. Input is held back while the
+// clock is more than the class's flood_burst seconds in the future.
+bool Client::isFlooding(unsigned long nowMs) const {
+    if (connectionClass == NULL || connectionClass->floodExempt)
+        return false;
+    return floodClock > nowMs + connectionClass->floodBurst * 1000;
+}
+
+void Client::chargeFlood(unsigned int costMs, unsigned long nowMs) {
+    if (floodClock < nowMs)
+        floodClock = nowMs;
+    floodClock += costMs;
+}
+
+// Earliest time at which isFlooding() turns false again.
+unsigned long Client::getFloodResumeMs() const {
+    if (connectionClass == NULL)
+        return floodClock;
+    return floodClock - connectionClass->floodBurst * 1000;
+}
+
+bool Client::isReadPaused() const {
+    return readPaused;
+}
+
+void Client::setReadPaused(bool paused) {
+    this->readPaused = paused;
+}
+
+void Client::setAddress(const std::string& addr) {
+    this->address = addr;
+}
+
+const std::string& Client::getAddress() const {
+    return address;
+}
+
+// 'counted' tells whether the throttle counted this connection against
+// its source, i.e. whether it has to be released on disconnect.
+void Client::setSource(const NetMask& src, bool counted) {
+    this->source = src;
+    this->sourceCounted = counted;
+}
+
+const NetMask& Client::getSource() const {
+    return source;
+}
+
+bool Client::isSourceCounted() const {
+    return sourceCounted;
+}
+
+void Client::setConnectionClass(const ConnectionClass* cls) {
+    this->connectionClass = cls;
+}
+
+const ConnectionClass* Client::getConnectionClass() const {
+    return connectionClass;
+}
+
+size_t Client::getSendQueueBytes() const {
+    return sendQueueBytes;
+}
+
+unsigned long Client::getMessagesQueued() const {
+    return messagesQueued;
+}
+
+unsigned long Client::getDroppedMessages() const {
+    return droppedMessages;
+}
+
+unsigned long Client::getBytesSent() const {
+    return bytesSent;
+}
+
+unsigned long Client::getLinesReceived() const {
+    return linesReceived;
+}
+
+unsigned long Client::getBytesReceived() const {
+    return bytesReceived;
+}
+
+time_t Client::getConnectedAt() const {
+    return connectedAt;
 }
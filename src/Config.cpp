@@ -0,0 +1,219 @@
+#include "../includes/Config.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdlib>
+
+ConnectionClass::ConnectionClass(const std::string& name)
+    : name(name), sendqMax(512 * 1024), sendqHigh(256 * 1024), sendqLow(64 * 1024),
+      dropLowPriority(false), floodBurst(10), floodExempt(false), maxPerIp(10),
+      connectBurst(10), connectRate(1), limitCidr(32) {
+}
+
+Config::Config() : listenBacklog(128), historyLines(100), historyMemory(16 * 1024 * 1024) {
+    classes.push_back(ConnectionClass("default"));
+}
+
+Config::~Config() {
+}
+
+static std::string trim(const std::string& str) {
+    size_t start = str.find_first_not_of(" \t\r");
+    if (start == std::string::npos)
+        return "";
+    size_t end = str.find_last_not_of(" \t\r");
+    return str.substr(start, end - start + 1);
+}
+
+static std::runtime_error configError(int lineNo, const std::string& msg) {
+    std::ostringstream oss;
+    oss << "config line " << lineNo << ": " << msg;
+    return std::runtime_error(oss.str());
+}
+
+// Accepts a plain byte count or a K/M/G suffixed one ("512K").
+static size_t parseSize(const std::string& value, int lineNo) {
+    char* end;
+    unsigned long n = std::strtoul(value.c_str(), &end, 10);
+    if (end == value.c_str())
+        throw configError(lineNo, "invalid size '" + value + "'");
+    std::string suffix = end;
+    if (suffix == "K" || suffix == "k")
+        n *= 1024;
+    else if (suffix == "M" || suffix == "m")
+        n *= 1024 * 1024;
+    else if (suffix == "G" || suffix == "g")
+        n *= 1024 * 1024 * 1024;
+    else if (!suffix.empty())
+        throw configError(lineNo, "invalid size '" + value + "'");
+    return n;
+}
+
+static unsigned long parseNumber(const std::string& value, int lineNo) {
+    char* end;
+    unsigned long n = std::strtoul(value.c_str(), &end, 10);
+    if (end == value.c_str() || *end != '\0')
+        throw configError(lineNo, "invalid number '" + value + "'");
+    return n;
+}
+
+static bool parseBool(const std::string& value, int lineNo) {
+    if (value == "yes" || value == "true" || value == "1")
+        return true;
+    if (value == "no" || value == "false" || value == "0")
+        return false;
+    throw configError(lineNo, "invalid boolean '" + value + "'");
+}
+
+void Config::setServerValue(const std::string& key, const std::string& value, int lineNo) {
+    if (key == "listen_backlog")
+        listenBacklog = parseNumber(value, lineNo);
+    else if (key == "dline_file")
+        dlineFile = value;
+    else if (key == "history_lines")
+        historyLines = parseNumber(value, lineNo);
+    else if (key == "history_memory")
+        historyMemory = parseSize(value, lineNo);
+    else
+        throw configError(lineNo, "unknown server setting '" + key + "'");
+}
+
+void Config::setClassValue(ConnectionClass& cls, const std::string& key,
+                           const std::string& value, int lineNo) {
+    if (key == "hosts") {
+        std::istringstream iss(value);
+        std::string mask;
+        while (iss >> mask) {
+            NetMask parsed;
+            if (!NetMask::parse(mask, parsed))
+                throw configError(lineNo, "invalid address mask '" + mask + "'");
+            cls.hosts.push_back(parsed);
+        }
+    }
+    else if (key == "sendq_max")
+        cls.sendqMax = parseSize(value, lineNo);
+    else if (key == "sendq_high")
+        cls.sendqHigh = parseSize(value, lineNo);
+    else if (key == "sendq_low")
+        cls.sendqLow = parseSize(value, lineNo);
+    else if (key == "drop_low_priority")
+        cls.dropLowPriority = parseBool(value, lineNo);
+    else if (key == "flood_burst")
+        cls.floodBurst = parseNumber(value, lineNo);
+    else if (key == "flood_exempt")
+        cls.floodExempt = parseBool(value, lineNo);
+    else if (key == "max_per_ip")
+        cls.maxPerIp = parseNumber(value, lineNo);
+    else if (key == "connect_burst")
+        cls.connectBurst = parseNumber(value, lineNo);
+    else if (key == "connect_rate")
+        cls.connectRate = parseNumber(value, lineNo);
+    else if (key == "limit_cidr")
+        cls.limitCidr = parseNumber(value, lineNo);
+    else
+        throw configError(lineNo, "unknown class setting '" + key + "'");
+}
+
+void Config::load(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file)
+        throw std::runtime_error("cannot open config file '" + path + "'");
+
+    std::string line;
+    int lineNo = 0;
+    // -1: before any section, -2: [server], otherwise a class index.
+    int section = -1;
+    while (std::getline(file, line)) {
+        lineNo++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line = line.substr(0, comment);
+        line = trim(line);
+        if (line.empty())
+            continue;
+
+        if (line[0] == '[') {
+            if (line[line.length() - 1] != ']')
+                throw configError(lineNo, "unterminated section header");
+            std::istringstream iss(line.substr(1, line.length() - 2));
+            std::string kind, name, extra;
+            iss >> kind >> name >> extra;
+            if (kind == "server" && name.empty()) {
+                section = -2;
+                continue;
+            }
+            if (kind != "class" || name.empty() || !extra.empty())
+                throw configError(lineNo, "unknown section '" + line + "'");
+            section = -1;
+            for (size_t i = 0; i < classes.size(); i++) {
+                if (classes[i].name == name)
+                    section = i;
+            }
+            if (section == -1) {
+                classes.push_back(ConnectionClass(name));
+                section = classes.size() - 1;
+            }
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos)
+            throw configError(lineNo, "expected 'key = value'");
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        if (section == -1)
+            throw configError(lineNo, "unknown setting '" + key + "'");
+        if (section == -2)
+            setServerValue(key, value, lineNo);
+        else
+            setClassValue(classes[section], key, value, lineNo);
+    }
+    validate();
+}
+
+void Config::validate() const {
+    if (listenBacklog <= 0)
+        throw std::runtime_error("server: listen_backlog must be positive");
+    for (size_t i = 0; i < classes.size(); i++) {
+        const ConnectionClass& cls = classes[i];
+        if (cls.sendqMax == 0 || cls.sendqLow > cls.sendqHigh || cls.sendqHigh > cls.sendqMax)
+            throw std::runtime_error("class '" + cls.name
+                + "': expected sendq_low <= sendq_high <= sendq_max and sendq_max > 0");
+        if (cls.limitCidr < 0 || cls.limitCidr > 32)
+            throw std::runtime_error("class '" + cls.name + "': limit_cidr must be 0-32");
+        if (cls.connectBurst != 0 && cls.connectRate == 0)
+            throw std::runtime_error("class '" + cls.name
+                + "': connect_rate must be positive when connect_burst is set");
+    }
+}
+
+// classes[0] is always "default" and only used as the fallback.
+const ConnectionClass& Config::findClass(const NetMask& address) const {
+    for (size_t i = 1; i < classes.size(); i++) {
+        for (size_t j = 0; j < classes[i].hosts.size(); j++) {
+            if (classes[i].hosts[j].contains(address))
+                return classes[i];
+        }
+    }
+    return classes[0];
+}
+
+const std::vector<ConnectionClass>& Config::getClasses() const {
+    return classes;
+}
+
+int Config::getListenBacklog() const {
+    return listenBacklog;
+}
+
+const std::string& Config::getDlineFile() const {
+    return dlineFile;
+}
+
+size_t Config::getHistoryLines() const {
+    return historyLines;
+}
+
+size_t Config::getHistoryMemory() const {
+    return historyMemory;
+}
@@ -0,0 +1,117 @@
+#include "../includes/ConnectionThrottle.hpp"
+#include "../includes/CaseMapping.hpp"
+#include "../includes/Config.hpp"
+#include <cstring>
+
+// Scores are kept in thousandths of a connection so that connect_rate
+// can drain them per millisecond without rounding everything to zero.
+#define SCORE_UNIT 1000
+
+ConnectionThrottle::ConnectionThrottle() : count(0) {
+}
+
+NetMask ConnectionThrottle::sourceOf(const NetMask& address, const ConnectionClass& cls) {
+    NetMask source = address;
+    if (source.isIPv4())
+        source.truncate(96 + cls.limitCidr);
+    else
+        source.truncate(64);
+    return source;
+}
+
+size_t ConnectionThrottle::locate(const NetMask& source, uint64_t hash) const {
+    size_t mask = table.size() - 1;
+    size_t i = hash & mask;
+    while (table[i].used) {
+        if (table[i].hash == hash && table[i].source.bits == source.bits
+            && std::memcmp(table[i].source.addr, source.addr, sizeof(source.addr)) == 0)
+            return i;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void ConnectionThrottle::decay(Entry& entry, unsigned long nowMs) {
+    unsigned long drained = (nowMs - entry.updatedMs) * entry.rate;
+    entry.score = (drained >= entry.score) ? 0 : entry.score - drained;
+    entry.updatedMs = nowMs;
+}
+
+// Rehashes the live sources into a table at most half full, dropping the
+// ones with no open connection and a fully drained score.
+void ConnectionThrottle::rebuild(unsigned long nowMs) {
+    std::vector<Entry> old;
+    size_t live = 0;
+
+    old.swap(table);
+    for (size_t i = 0; i < old.size(); i++) {
+        if (!old[i].used)
+            continue;
+        decay(old[i], nowMs);
+        if (old[i].connections > 0 || old[i].score > 0)
+            live++;
+        else
+            old[i].used = false;
+    }
+    size_t size = 16;
+    while ((live + 1) * 2 > size)
+        size *= 2;
+    table.resize(size);
+    count = 0;
+    for (size_t i = 0; i < old.size(); i++) {
+        if (!old[i].used)
+            continue;
+        table[locate(old[i].source, old[i].hash)] = old[i];
+        count++;
+    }
+}
+
+ConnectionThrottle::Verdict ConnectionThrottle::admit(const NetMask& source,
+        const ConnectionClass& cls, unsigned long nowMs) {
+    if (cls.maxPerIp == 0 && cls.connectBurst == 0)
+        return EXEMPT;
+    if ((count + 1) * 4 > table.size() * 3)
+        rebuild(nowMs);
+
+    uint64_t hash = keyedHash(reinterpret_cast<const char*>(source.addr), sizeof(source.addr));
+    Entry& entry = table[locate(source, hash)];
+    if (!entry.used) {
+        entry.source = source;
+        entry.hash = hash;
+        entry.connections = 0;
+        entry.score = 0;
+        entry.updatedMs = nowMs;
+        entry.used = true;
+        count++;
+    }
+    entry.rate = cls.connectRate;
+    decay(entry, nowMs);
+
+    if (cls.maxPerIp != 0 && entry.connections >= cls.maxPerIp)
+        return TOO_MANY_CONNECTIONS;
+    if (cls.connectBurst != 0) {
+        unsigned long limit = cls.connectBurst * SCORE_UNIT;
+        if (entry.score + SCORE_UNIT > limit) {
+            // Keep a reconnect storm pinned at the limit: the source is
+            // only let back in once it actually slows down.
+            entry.score = limit;
+            return TOO_FAST;
+        }
+        entry.score += SCORE_UNIT;
+    }
+    entry.connections++;
+    return ADMITTED;
+}
+
+void ConnectionThrottle::release(const NetMask& source) {
+    if (count == 0)
+        return;
+    uint64_t hash = keyedHash(reinterpret_cast<const char*>(source.addr), sizeof(source.addr));
+    Entry& entry = table[locate(source, hash)];
+    if (entry.used && entry.connections > 0)
+        entry.connections--;
+}
+
+size_t ConnectionThrottle::size() const {
+    return count;
+}
@@ -0,0 +1,197 @@
+#include "../includes/HistoryIndex.hpp"
+#include <algorithm>
+#include <iterator>
+
+#define MIN_TOKEN_LENGTH 2
+#define MAX_TOKEN_LENGTH 32
+
+HistoryIndex::HistoryIndex() : livePostings(0), deadPostings(0), bytes(0) {
+}
+
+HistoryIndex::~HistoryIndex() {
+    clear();
+}
+
+static bool isTokenByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c >= 0x80;
+}
+
+static void putVarint(std::string& out, unsigned long value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+static unsigned long getVarint(const std::string& in, size_t& pos) {
+    unsigned long value = 0;
+    int shift = 0;
+    while (pos < in.length()) {
+        unsigned char byte = in[pos++];
+        value |= static_cast<unsigned long>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            break;
+        shift += 7;
+    }
+    return value;
+}
+
+// Splits text into index tokens. Tokens longer than MAX_TOKEN_LENGTH
+// are cut, so a query for a long word still matches its prefix.
+void HistoryIndex::tokenize(const std::string& text, std::vector<StringView>& tokens) {
+    size_t i = 0;
+    while (i < text.length()) {
+        while (i < text.length() && !isTokenByte(text[i]))
+            i++;
+        size_t start = i;
+        while (i < text.length() && isTokenByte(text[i]))
+            i++;
+        size_t len = std::min(i - start, static_cast<size_t>(MAX_TOKEN_LENGTH));
+        if (len >= MIN_TOKEN_LENGTH)
+            tokens.push_back(StringView(text.data() + start, len));
+    }
+}
+
+// Indexes message 'id' (which must be newer than every indexed one) and
+// returns the number of postings it added.
+size_t HistoryIndex::add(unsigned long id, const std::string& text) {
+    std::vector<StringView> tokens;
+    size_t added = 0;
+
+    tokenize(text, tokens);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        Posting* posting = postings.find(tokens[i].data, tokens[i].length);
+        if (posting == NULL) {
+            posting = new Posting();
+            posting->token = tokens[i].str();
+            posting->lastId = 0;
+            posting->count = 0;
+            postings.insert(posting->token, posting);
+            bytes += sizeof(Posting) + posting->token.length();
+        }
+        else if (posting->lastId == id)
+            continue;
+        size_t before = posting->gaps.length();
+        putVarint(posting->gaps, id - posting->lastId);
+        bytes += posting->gaps.length() - before;
+        posting->lastId = id;
+        posting->count++;
+        added++;
+    }
+    livePostings += added;
+    return added;
+}
+
+// Records that a message with 'count' postings left the history;
+// oldestId is the oldest id still in it.
+void HistoryIndex::retire(size_t count, unsigned long oldestId) {
+    livePostings -= count;
+    deadPostings += count;
+    if (deadPostings > livePostings)
+        prune(oldestId);
+}
+
+// Cuts the ids below oldestId off the front of every posting. Only the
+// first surviving gap is re-encoded; the rest is copied as is. The token
+// table is rebuilt from the survivors, since it never shrinks on erase.
+void HistoryIndex::prune(unsigned long oldestId) {
+    std::vector<Posting*> all;
+    CaseFoldMap<Posting*> live;
+    postings.values(all);
+    for (size_t i = 0; i < all.size(); i++) {
+        Posting* posting = all[i];
+        if (posting->lastId < oldestId) {
+            bytes -= sizeof(Posting) + posting->token.length() + posting->gaps.length();
+            delete posting;
+            continue;
+        }
+        live.insert(posting->token, posting);
+        size_t next = 0;
+        unsigned long id = 0;
+        size_t dropped = 0;
+        while (next < posting->gaps.length()) {
+            id += getVarint(posting->gaps, next);
+            if (id >= oldestId)
+                break;
+            dropped++;
+        }
+        if (dropped == 0)
+            continue;
+        std::string gaps;
+        putVarint(gaps, id);
+        gaps.append(posting->gaps, next, std::string::npos);
+        bytes -= posting->gaps.length() - gaps.length();
+        posting->gaps.swap(gaps);
+        posting->count -= dropped;
+    }
+    postings = live;
+    deadPostings = 0;
+}
+
+void HistoryIndex::decode(const Posting& posting, unsigned long oldestId,
+                          std::vector<unsigned long>& ids) {
+    size_t pos = 0;
+    unsigned long id = 0;
+    ids.clear();
+    ids.reserve(posting.count);
+    while (pos < posting.gaps.length()) {
+        id += getVarint(posting.gaps, pos);
+        if (id >= oldestId)
+            ids.push_back(id);
+    }
+}
+
+// Fills ids, oldest first, with the messages from oldestId on that
+// contain every token of query. Lists are intersected shortest first.
+void HistoryIndex::search(const std::string& query, unsigned long oldestId,
+                          std::vector<unsigned long>& ids) const {
+    std::vector<StringView> tokens;
+    std::vector<const Posting*> lists;
+
+    ids.clear();
+    tokenize(query, tokens);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const Posting* posting = postings.find(tokens[i].data, tokens[i].length);
+        if (posting == NULL)
+            return;
+        lists.push_back(posting);
+    }
+    if (lists.empty())
+        return;
+
+    size_t shortest = 0;
+    for (size_t i = 1; i < lists.size(); i++) {
+        if (lists[i]->count < lists[shortest]->count)
+            shortest = i;
+    }
+    decode(*lists[shortest], oldestId, ids);
+
+    std::vector<unsigned long> other;
+    std::vector<unsigned long> common;
+    for (size_t i = 0; i < lists.size() && !ids.empty(); i++) {
+        if (i == shortest || lists[i] == lists[shortest])
+            continue;
+        decode(*lists[i], oldestId, other);
+        common.clear();
+        std::set_intersection(ids.begin(), ids.end(), other.begin(), other.end(),
+                              std::back_inserter(common));
+        ids.swap(common);
+    }
+}
+
+void HistoryIndex::clear() {
+    std::vector<Posting*> all;
+    postings.values(all);
+    for (size_t i = 0; i < all.size(); i++)
+        delete all[i];
+    postings = CaseFoldMap<Posting*>();
+    livePostings = 0;
+    deadPostings = 0;
+    bytes = 0;
+}
+
+// Postings, tokens and gaps, plus the token table's slots.
+size_t HistoryIndex::getBytes() const {
+    return bytes + postings.tableBytes();
+}
@@ -18,40 +18,40 @@ void InviteCommand::execute() {
     if (nick.empty()) nick = "*";
 
     if (!client->isRegistered()) {
-        client->sendMessage(ERR_NOTREGISTERED(nick) + "\r\n");
+        client->sendReply(ERR_NOTREGISTERED(nick));
         return;
     }
     if (params.size() < 2) {
-        client->sendMessage(ERR_NEEDMOREPARAMS(nick, "INVITE") + "\r\n");
+        client->sendReply(ERR_NEEDMOREPARAMS(nick, "INVITE"));
         return;
     }
     std::string targetNick = params[0];
     std::string channelName = params[1];
     Channel* channel = server->getChannel(channelName);
     if (!channel) {
-        client->sendMessage(ERR_NOSUCHCHANNEL(nick, channelName) + "\r\n");
+        client->sendReply(ERR_NOSUCHCHANNEL(nick, channelName));
         return;
     }
     if (!channel->isMember(client)) {
-        client->sendMessage(ERR_NOTONCHANNEL(nick, channelName) + "\r\n");
+        client->sendReply(ERR_NOTONCHANNEL(nick, channelName));
         return;
     }
     if (channel->isChannelInvitOnly() && !channel->isOperator(client)) {
-        client->sendMessage(ERR_CHANOPRIVSNEEDED(nick, channelName) + "\r\n");
+        client->sendReply(ERR_CHANOPRIVSNEEDED(nick, channelName));
         return;
     }
     Client* targetClient = server->getClientByNick(targetNick);
     if (!targetClient) {
-        client->sendMessage(ERR_NOSUCHNICK(nick, targetNick) + "\r\n");
+        client->sendReply(ERR_NOSUCHNICK(nick, targetNick));
         return;
     }
     if (channel->isMember(targetClient)) {
-        client->sendMessage(ERR_USERONCHANNEL(nick, targetNick, channelName) + "\r\n");
+        client->sendReply(ERR_USERONCHANNEL(nick, targetNick, channelName));
         return;
     }
     channel->inviteUser(targetClient);
     std::string inviteMsg =client->getPrefix() + " INVITE " +
                           targetNick + " " + channelName + "\r\n";
     targetClient->sendMessage(inviteMsg);
-    client->sendMessage(RPL_INVITING(nick, targetNick, channelName) + "\r\n");
+    client->sendReply(RPL_INVITING(nick, targetNick, channelName));
 }
\ No newline at end of file
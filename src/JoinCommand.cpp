@@ -30,17 +30,17 @@ void JoinCommand::execute() {
     std::string nick = client->getNickname();
     if (nick.empty()) nick = "*";
     if (!client->isRegistered()) {
-        client->sendMessage(ERR_NOTREGISTERED(nick) + "\r\n");
+        client->sendReply(ERR_NOTREGISTERED(nick));
         return;
     }
     if (params.empty() || params[0].empty()) {
-        client->sendMessage(ERR_NEEDMOREPARAMS(nick, "JOIN") + "\r\n");
+        client->sendReply(ERR_NEEDMOREPARAMS(nick, "JOIN"));
         return;
     }
     if (params[0] == "0") {
-        std::set<Channel*> clientChannels = client->getChannels();
-        for (std::set<Channel*>::iterator it = clientChannels.begin(); it != clientChannels.end(); ++it) {
-            Channel* channel = *it;
+        std::map<Channel*, size_t> clientChannels = client->getChannels();
+        for (std::map<Channel*, size_t>::iterator it = clientChannels.begin(); it != clientChannels.end(); ++it) {
+            Channel* channel = it->first;
             std::string channelName = channel->getName();
             std::string partMsg = client->getPrefix() + " PART " + channelName + "\r\n";
             channel->broadcast(partMsg, client);
@@ -56,13 +56,13 @@ void JoinCommand::execute() {
     for (size_t i = 0; i < channelsToJoin.size(); i++) {
         std::string channelName = channelsToJoin[i];
         if (!server->isValidName(channelName)) {
-            client->sendMessage(ERR_NOSUCHCHANNEL(nick, channelName) + "\r\n");
+            client->sendReply(ERR_NOSUCHCHANNEL(nick, channelName));
             continue;
         }
         bool isNewChannel = !server->channelExistOrNot(channelName);
         Channel* channel = server->getOrCreateChannel(channelName);
         if(channel == NULL) {
-            client->sendMessage(ERR_NOSUCHCHANNEL(nick, channelName) + "\r\n");
+            client->sendReply(ERR_NOSUCHCHANNEL(nick, channelName));
             continue;
         }
         if (!isNewChannel) {
@@ -72,16 +72,16 @@ void JoinCommand::execute() {
             if (channel->hasKey()) {
                 std::string providedKey = (i < channelKeys.size()) ? channelKeys[i] : "";
                 if (!channel->checkKey(providedKey)) {
-                    client->sendMessage(ERR_BADCHANNELKEY(nick, channelName) + "\r\n");
+                    client->sendReply(ERR_BADCHANNELKEY(nick, channelName));
                     continue;
                 }
             }
             if (channel->isChannelInvitOnly() && channel->isInvited(client) == false) {
-                client->sendMessage(ERR_INVITEONLYCHAN(nick, channelName) + "\r\n");
+                client->sendReply(ERR_INVITEONLYCHAN(nick, channelName));
                 continue;
             }
             if (channel->isChannelFull()) {
-                client->sendMessage(ERR_CHANNELISFULL(nick, channelName) + "\r\n");
+                client->sendReply(ERR_CHANNELISFULL(nick, channelName));
                 continue;
             }
         }
@@ -18,12 +18,12 @@ void KickCommand::execute() {
     if (nick.empty()) nick = "*";
     
     if (!client->isRegistered()) {
-        client->sendMessage(ERR_NOTREGISTERED(nick) + "\r\n");
+        client->sendReply(ERR_NOTREGISTERED(nick));
         return;
     }
     
     if (params.size() < 2) {
-        client->sendMessage(ERR_NEEDMOREPARAMS(nick, "KICK") + "\r\n");
+        client->sendReply(ERR_NEEDMOREPARAMS(nick, "KICK"));
         return;
     }
     if (params.size() >3) {
@@ -42,29 +42,29 @@ void KickCommand::execute() {
         reason = client->getNickname();
     }
     if (!server->channelExistOrNot(channelName)) {
-        client->sendMessage(ERR_NOSUCHCHANNEL(nick, channelName) + "\r\n");
+        client->sendReply(ERR_NOSUCHCHANNEL(nick, channelName));
         return;
     }
     Channel* channel = server->getChannel(channelName);
 
     if (!channel->isMember(client)) {
-        client->sendMessage(ERR_NOTONCHANNEL(nick, channelName) + "\r\n");
+        client->sendReply(ERR_NOTONCHANNEL(nick, channelName));
         return;
     }
 
     if (!channel->isOperator(client)) {
-        client->sendMessage(ERR_CHANOPRIVSNEEDED(nick, channelName) + "\r\n");
+        client->sendReply(ERR_CHANOPRIVSNEEDED(nick, channelName));
         return;
     }
     
     Client* target = server->getClientByNick(targetNick);
     if (target == NULL) {
-        client->sendMessage(ERR_NOSUCHNICK(nick, targetNick) + "\r\n");
+        client->sendReply(ERR_NOSUCHNICK(nick, targetNick));
         return;
     }
 
     if (!channel->isMember(target)) {
-        client->sendMessage(ERR_USERNOTINCHANNEL(nick, targetNick, channelName) + "\r\n");
+        client->sendReply(ERR_USERNOTINCHANNEL(nick, targetNick, channelName));
         return;
     }
     channel->kickMember(client, target, reason);
@@ -16,144 +16,189 @@
 #include "../includes/NoticeCommand.hpp"
 #include "../includes/PingCommand.hpp"
 #include "../includes/PongCommand.hpp"
+#include "../includes/StatsCommand.hpp"
+#include "../includes/ChathistoryCommand.hpp"
+#include "../includes/SearchCommand.hpp"
+#include "../includes/CapCommand.hpp"
 #include "../includes/Replies.hpp"
 #include <iostream>
 #include <string>
 #include <exception>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
 
-Command* MessageParser::createCommand(const std::string& cmd, Server* srv, Client* cli,
-        const std::vector<std::string>& params)
-{
-    try{
-        if (cmd == "INVITE") {
-            return new InviteCommand(srv, cli, params);
-        }
-        else if (cmd == "JOIN") {
-            return new JoinCommand(srv, cli, params);
-        }
-        else if (cmd == "KICK") {
-            return new KickCommand(srv, cli, params);
-        }
-        else if (cmd == "MODE") {
-            return new ModeCommand(srv, cli, params);
-        }
-        else if (cmd == "NICK") {
-            return new NickCommand(srv, cli, params);
-        }
-        else if (cmd == "PART") {
-            return new PartCommand(srv, cli, params);
-        }
-        else if (cmd == "PASS") {
-            return new PassCommand(srv, cli, params);
-        }
-        else if (cmd == "PRIVMSG") {
-            return new PrivmsgCommand(srv, cli, params);
-        }
-        else if (cmd == "QUIT") {
-            return new QuitCommand(srv, cli, params);
-        }
-        else if (cmd == "TOPIC") {
-            return new TopicCommand(srv, cli, params);
-        }
-        else if (cmd == "USER") {
-            return new UserCommand(srv, cli, params);
-        }
-        else if (cmd == "NOTICE") {
-            return new NoticeCommand(srv, cli, params);
-        }
-        else if (cmd == "PING") {
-            return new PingCommand(srv, cli, params);
-        }
-        else if (cmd == "PONG") {
-            return new PongCommand(srv, cli, params);
-        }
+// Commands run as stack objects borrowing the parsed parameter vector,
+// so dispatching a line costs no allocation beyond the parse itself.
+template <typename T>
+static void runCommand(Server* srv, Client* cli, const std::vector<std::string>& params) {
+    T command(srv, cli, params);
+    command.execute();
+}
+
+static CommandEntry commandTable[] = {
+    { "PRIVMSG", &runCommand<PrivmsgCommand>, 1000, 0, 0 },
+    { "PING",    &runCommand<PingCommand>,     500, 0, 0 },
+    { "PONG",    &runCommand<PongCommand>,       0, 0, 0 },
+    { "NOTICE",  &runCommand<NoticeCommand>,  1000, 0, 0 },
+    { "JOIN",    &runCommand<JoinCommand>,    1000, 0, 0 },
+    { "PART",    &runCommand<PartCommand>,     500, 0, 0 },
+    { "MODE",    &runCommand<ModeCommand>,     500, 0, 0 },
+    { "TOPIC",   &runCommand<TopicCommand>,   1000, 0, 0 },
+    { "KICK",    &runCommand<KickCommand>,    1000, 0, 0 },
+    { "INVITE",  &runCommand<InviteCommand>,  1000, 0, 0 },
+    { "NICK",    &runCommand<NickCommand>,    2000, 0, 0 },
+    { "USER",    &runCommand<UserCommand>,       0, 0, 0 },
+    { "PASS",    &runCommand<PassCommand>,       0, 0, 0 },
+    { "QUIT",    &runCommand<QuitCommand>,       0, 0, 0 },
+    { "STATS",   &runCommand<StatsCommand>,   1000, 0, 0 },
+    { "CHATHISTORY", &runCommand<ChathistoryCommand>, 1000, 0, 0 },
+    { "SEARCH",  &runCommand<SearchCommand>,  1000, 0, 0 },
+    { "CAP",     &runCommand<CapCommand>,        0, 0, 0 }
+};
+
+#define COMMAND_COUNT (sizeof(commandTable) / sizeof(commandTable[0]))
+#define COMMAND_SLOTS 64
+
+// Open-addressed index into commandTable, keyed by a case-insensitive
+// hash of the command name. Built on first use.
+static unsigned char commandSlots[COMMAND_SLOTS];
+static bool commandSlotsReady = false;
+
+static size_t commandHash(const char* name, size_t len) {
+    size_t h = len;
+    for (size_t i = 0; i < len; i++)
+        h = h * 31 + (std::toupper(static_cast<unsigned char>(name[i])) & 0xff);
+    return h & (COMMAND_SLOTS - 1);
+}
+
+static void buildCommandSlots() {
+    std::memset(commandSlots, 0xff, sizeof(commandSlots));
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        size_t slot = commandHash(commandTable[i].name, std::strlen(commandTable[i].name));
+        while (commandSlots[slot] != 0xff)
+            slot = (slot + 1) & (COMMAND_SLOTS - 1);
+        commandSlots[slot] = static_cast<unsigned char>(i);
     }
-    catch (std::exception& e) {
-        cli->sendMessage(e.what());
-        return NULL;
+    commandSlotsReady = true;
+}
+
+static bool sameCommand(const char* name, const StringView& cmd) {
+    size_t i = 0;
+    for (; i < cmd.length; i++) {
+        if (name[i] == '\0' ||
+            name[i] != std::toupper(static_cast<unsigned char>(cmd.data[i])))
+            return false;
     }
-    cli->sendMessage(ERR_UNKNOWNCOMMAND(cli->getNickname(), cmd) + "\r\n");
-    return NULL;
+    return name[i] == '\0';
 }
 
-std::string MessageParser::extractPrefix(const std::string& line) {
-    size_t  pos;
+CommandEntry* MessageParser::findCommand(const StringView& cmd) {
+    if (!commandSlotsReady)
+        buildCommandSlots();
+    size_t slot = commandHash(cmd.data, cmd.length);
+    while (commandSlots[slot] != 0xff) {
+        CommandEntry* entry = &commandTable[commandSlots[slot]];
+        if (sameCommand(entry->name, cmd))
+            return entry;
+        slot = (slot + 1) & (COMMAND_SLOTS - 1);
+    }
+    return NULL;
+}
 
-    if (line.empty() || line[0] != ':')
-        return "";
-    pos = line.find(" ");
-    if (pos == std::string::npos)
-        return line;
-    return line.substr(0, pos);
+const CommandEntry* MessageParser::getCommandTable(size_t& count) {
+    count = COMMAND_COUNT;
+    return commandTable;
 }
 
-std::string MessageParser::removePrefix(const std::string& line) {
-    std::string prefix;
-    std::string cmdLine;
-    size_t      pos;
+static const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && *p == ' ')
+        ++p;
+    return p;
+}
 
-    cmdLine = line;
-    if (line.empty())
-        return "";
-    if (line[0] == ':')
-    {
-        prefix = MessageParser::extractPrefix(line);
-        pos = prefix.size();
-        while (line.size() > pos && line[pos] == ' ')
-            ++pos;
-        cmdLine = line.substr(pos, line.size() - pos);
-    }
-    return (cmdLine);
+static const char* skipToken(const char* p, const char* end) {
+    while (p < end && *p != ' ')
+        ++p;
+    return p;
 }
 
-std::vector<std::string> MessageParser::splitParams(const std::string& str) {
-    std::vector<std::string>    result;
-    std::string                 cmdLine;
-    size_t                      pos;
+// Splits one line (CRLF already stripped) in a single pass: optional
+// IRCv3 "@tags", optional ":prefix", the command, then up to MAX_PARAMS
+// parameters. The last parameter takes the rest of the line when it
+// starts with ':' or the limit is reached; it keeps the ':' because the
+// handlers forward it verbatim. Returns false when there is no command.
+bool MessageParser::parse(const StringView& line, IrcMessage& msg) {
+    const char* p = line.data;
+    const char* end = line.data + line.length;
+    const char* start;
 
-    cmdLine = MessageParser::removePrefix(str);
-    if (cmdLine.empty())
-        return std::vector<std::string>();
-    while (!cmdLine.empty() && cmdLine[0] != ':')
-    {
-        pos = cmdLine.find(" ");
-        if (pos == std::string::npos)
-            pos = cmdLine.size();
-        result.push_back(cmdLine.substr(0, pos));
-        while (cmdLine[pos] == ' ')
-            ++pos;
-        cmdLine = cmdLine.substr(pos, cmdLine.size() - pos);
+    msg.tags = StringView();
+    msg.prefix = StringView();
+    msg.command = StringView();
+    msg.paramCount = 0;
+    if (p < end && *p == '@') {
+        start = ++p;
+        p = skipToken(p, end);
+        msg.tags = StringView(start, p - start);
+        p = skipSpaces(p, end);
     }
-    if (!cmdLine.empty())
-    {
-        result.push_back(cmdLine);
+    if (p < end && *p == ':') {
+        start = ++p;
+        p = skipToken(p, end);
+        msg.prefix = StringView(start, p - start);
     }
-    if (!result.empty()) {
-        std::string& last = result.back();
-        if (last.size() >= 2 && last[last.size() - 2] == '\r' && last[last.size() - 1] == '\n') {
-            last = last.substr(0, last.size() - 2);
-        } else if (last.size() >= 1 && last[last.size() - 1] == '\n') {
-            last = last.substr(0, last.size() - 1);
-        } else if (last.size() >= 1 && last[last.size() - 1] == '\r') {
-            last = last.substr(0, last.size() - 1);
+    p = skipSpaces(p, end);
+    start = p;
+    p = skipToken(p, end);
+    msg.command = StringView(start, p - start);
+    if (msg.command.empty())
+        return false;
+    while (true) {
+        p = skipSpaces(p, end);
+        if (p == end)
+            break;
+        if (*p == ':' || msg.paramCount == MAX_PARAMS - 1) {
+            msg.params[msg.paramCount++] = StringView(p, end - p);
+            break;
         }
+        start = p;
+        p = skipToken(p, end);
+        msg.params[msg.paramCount++] = StringView(start, p - start);
     }
-    return result;
+    return true;
 }
 
-Command* MessageParser::parse(const std::string& line, Server* srv, Client* cli) {
-    std::vector<std::string>    params;
-    std::string                 cmd;
+// Runs one line and returns the fake lag it costs the sender.
+unsigned int MessageParser::dispatch(const StringView& line, Server* srv, Client* cli) {
+    static std::vector<std::string> params;
+    IrcMessage msg;
 
-    params = MessageParser::splitParams(line);
-    if (params.empty())
+    if (!MessageParser::parse(line, msg))
     {
-        cli->sendMessage(ERR_UNKNOWNCOMMAND(cli->getNickname(), line) + "\r\n");
-        return NULL;
+        cli->sendReply(ERR_UNKNOWNCOMMAND(cli->getNickname(), line));
+        return UNKNOWN_COMMAND_COST;
+    }
+    CommandEntry* entry = MessageParser::findCommand(msg.command);
+    if (entry == NULL) {
+        char cmd[MAX_LINE_LENGTH];
+        size_t len = std::min(msg.command.length, sizeof(cmd));
+        for (size_t i = 0; i < len; i++)
+            cmd[i] = std::toupper(static_cast<unsigned char>(msg.command.data[i]));
+        cli->sendReply(ERR_UNKNOWNCOMMAND(cli->getNickname(), StringView(cmd, len)));
+        return UNKNOWN_COMMAND_COST;
     }
-    cmd = params.front();
-    params.erase(params.begin());
-    for (long unsigned int i = 0; i < cmd.size(); i++)
-        cmd[i] = std::toupper(cmd[i]);
-    return MessageParser::createCommand(cmd, srv, cli, params);
-}
\ No newline at end of file
+    entry->calls++;
+    entry->bytes += line.length;
+    // Reused across lines so the strings keep their capacity.
+    params.resize(msg.paramCount);
+    for (size_t i = 0; i < msg.paramCount; i++)
+        params[i].assign(msg.params[i].data, msg.params[i].length);
+    try {
+        entry->handler(srv, cli, params);
+    }
+    catch (std::exception& e) {
+        cli->sendMessage(e.what());
+    }
+    return entry->cost;
+}
@@ -20,11 +20,11 @@ Channel*    ModeCommand::checkErrorModes() {
     if (nick.empty())
         nick = "*";
     if (!client->isRegistered()) {
-        client->sendMessage(ERR_NOTREGISTERED(nick) + "\r\n");
+        client->sendReply(ERR_NOTREGISTERED(nick));
         return NULL;
     }
     if (params.size() == 0) {
-        client->sendMessage(ERR_NEEDMOREPARAMS(nick, "MODE") + "\r\n");
+        client->sendReply(ERR_NEEDMOREPARAMS(nick, "MODE"));
         return NULL;
     }
 
@@ -32,11 +32,11 @@ Channel*    ModeCommand::checkErrorModes() {
     Channel* channel = server->getChannel(channelName);
 
     if(channel == NULL) {
-        client->sendMessage(ERR_NOSUCHCHANNEL(nick, channelName) + "\r\n");
+        client->sendReply(ERR_NOSUCHCHANNEL(nick, channelName));
         return NULL;
     }
     if (!channel->isMember(client)) {
-        client->sendMessage(ERR_NOTONCHANNEL(nick, channelName) + "\r\n");
+        client->sendReply(ERR_NOTONCHANNEL(nick, channelName));
         return NULL;
     }
     return channel;
@@ -56,7 +56,7 @@ void    ModeCommand::showModes(Channel* channel) {
         ss << channel->getUserLimit();
         modeStr += ("l " + ss.str());
     }
-    client->sendMessage(RPL_CHANNELMODEIS(client->getNickname(), channel->getName(), modeStr, "") + "\r\n");
+    client->sendReply(RPL_CHANNELMODEIS(client->getNickname(), channel->getName(), modeStr, ""));
 }
 
 void ModeCommand::handleModeI(Channel* channel, bool adding, std::string& appliedModes) {
@@ -85,7 +85,7 @@ void ModeCommand::handleModeK(Channel* channel, bool adding, size_t& paramIndex,
             msg = client->getPrefix() + " MODE " + channel->getName() + " " + "+k" + appliedParams + "\r\n";
         }
         else {
-            client->sendMessage(ERR_NEEDMOREPARAMS(client->getNickname(), "MODE +k") + "\r\n");
+            client->sendReply(ERR_NEEDMOREPARAMS(client->getNickname(), "MODE +k"));
         }
     }
     else {
@@ -99,7 +99,7 @@ void ModeCommand::handleModeK(Channel* channel, bool adding, size_t& paramIndex,
 void ModeCommand::handleModeO(Channel* channel, bool adding, size_t& paramIndex,
                               std::string& appliedModes, std::string& appliedParams) {
     if (paramIndex >= params.size()) {
-        client->sendMessage(ERR_NEEDMOREPARAMS(client->getNickname(), "MODE +o") + "\r\n");
+        client->sendReply(ERR_NEEDMOREPARAMS(client->getNickname(), "MODE +o"));
         return;
     }
 
@@ -107,12 +107,12 @@ void ModeCommand::handleModeO(Channel* channel, bool adding, size_t& paramIndex,
     Client* target = server->getClientByNick(targetNick);
     
     if (target == NULL) {
-        client->sendMessage(ERR_NOSUCHNICK(client->getNickname(), targetNick) + "\r\n");
+        client->sendReply(ERR_NOSUCHNICK(client->getNickname(), targetNick));
         paramIndex++;
         return;
     }
     if (!channel->isMember(target)) {
-        client->sendMessage(ERR_USERNOTINCHANNEL(client->getNickname(), targetNick, channel->getName()) + "\r\n");
+        client->sendReply(ERR_USERNOTINCHANNEL(client->getNickname(), targetNick, channel->getName()));
         paramIndex++;
         return;
     }
@@ -141,7 +141,7 @@ void ModeCommand::handleModeL(Channel* channel, bool adding, size_t& paramIndex,
                 }
             }
             if (!isValid || limitStr.length() > 9) {
-                client->sendMessage(ERR_INVALIDMODEPARAM(client->getNickname(), channel->getName(), "l", limitStr, "Invalid limit value (must be a positive number)") + "\r\n");
+                client->sendReply(ERR_INVALIDMODEPARAM(client->getNickname(), channel->getName(), "l", limitStr, "Invalid limit value (must be a positive number)"));
                 paramIndex++;
                 return;
             }
@@ -149,7 +149,7 @@ void ModeCommand::handleModeL(Channel* channel, bool adding, size_t& paramIndex,
             long limit;
             iss >> limit;
             if (limit <= 0 || limit > 2147483647) {
-                client->sendMessage(ERR_INVALIDMODEPARAM(client->getNickname(), channel->getName(), "l", limitStr, "Limit must be a positive number") + "\r\n");
+                client->sendReply(ERR_INVALIDMODEPARAM(client->getNickname(), channel->getName(), "l", limitStr, "Limit must be a positive number"));
                 paramIndex++;
                 return;
             }
@@ -163,7 +163,7 @@ void ModeCommand::handleModeL(Channel* channel, bool adding, size_t& paramIndex,
             paramIndex++;
         }
         else {
-            client->sendMessage(ERR_NEEDMOREPARAMS(client->getNickname(), "MODE +l") + "\r\n");
+            client->sendReply(ERR_NEEDMOREPARAMS(client->getNickname(), "MODE +l"));
         }
     }
     else {
@@ -209,7 +209,7 @@ void ModeCommand::processModes(Channel* channel) {
                 handleModeL(channel, adding, paramIndex, appliedModes, appliedParams);
                 break;
             default:
-                client->sendMessage(ERR_UNKNOWNMODE(client->getNickname(), std::string(1, mode)) + "\r\n");
+                client->sendReply(ERR_UNKNOWNMODE(client->getNickname(), std::string(1, mode)));
                 break;
         }
     }
@@ -225,7 +225,7 @@ void ModeCommand::execute() {
         return;
     }
     if (!channel->isOperator(client)) {
-        client->sendMessage(ERR_CHANOPRIVSNEEDED(client->getNickname(), channel->getName()) + "\r\n");
+        client->sendReply(ERR_CHANOPRIVSNEEDED(client->getNickname(), channel->getName()));
         return;
     }
     else
@@ -0,0 +1,112 @@
+#include "../includes/NetMask.hpp"
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cstring>
+#include <cstdlib>
+#include <sstream>
+
+static const unsigned char V4_MAPPED_PREFIX[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+NetMask::NetMask() : bits(0) {
+    std::memset(addr, 0, sizeof(addr));
+}
+
+bool NetMask::parse(const std::string& str, NetMask& out) {
+    std::string host = str;
+    int prefix = -1;
+    size_t slash = str.find('/');
+
+    if (slash != std::string::npos) {
+        std::string len = str.substr(slash + 1);
+        if (len.empty() || len.length() > 3 || len.find_first_not_of("0123456789") != std::string::npos)
+            return false;
+        prefix = std::atoi(len.c_str());
+        host = str.substr(0, slash);
+    }
+
+    struct in_addr v4;
+    struct in6_addr v6;
+    if (inet_pton(AF_INET, host.c_str(), &v4) == 1) {
+        if (prefix > 32)
+            return false;
+        std::memcpy(out.addr, V4_MAPPED_PREFIX, 12);
+        std::memcpy(out.addr + 12, &v4, 4);
+        out.bits = 96 + (prefix < 0 ? 32 : prefix);
+    }
+    else if (inet_pton(AF_INET6, host.c_str(), &v6) == 1) {
+        if (prefix > 128)
+            return false;
+        std::memcpy(out.addr, &v6, 16);
+        out.bits = (prefix < 0 ? 128 : prefix);
+    }
+    else {
+        return false;
+    }
+    // Clear host bits so equal prefixes compare equal
+    for (int i = out.bits; i < 128; i++)
+        out.addr[i / 8] &= static_cast<unsigned char>(~(0x80 >> (i % 8)));
+    return true;
+}
+
+bool NetMask::fromSockaddr(const struct sockaddr* sa, NetMask& out) {
+    if (sa->sa_family == AF_INET) {
+        const struct sockaddr_in* in = reinterpret_cast<const struct sockaddr_in*>(sa);
+        std::memcpy(out.addr, V4_MAPPED_PREFIX, 12);
+        std::memcpy(out.addr + 12, &in->sin_addr, 4);
+        out.bits = 128;
+        return true;
+    }
+    if (sa->sa_family == AF_INET6) {
+        const struct sockaddr_in6* in6 = reinterpret_cast<const struct sockaddr_in6*>(sa);
+        std::memcpy(out.addr, &in6->sin6_addr, 16);
+        out.bits = 128;
+        return true;
+    }
+    return false;
+}
+
+bool NetMask::bitAt(int index) const {
+    return (addr[index / 8] & (0x80 >> (index % 8))) != 0;
+}
+
+bool NetMask::contains(const NetMask& address) const {
+    int fullBytes = bits / 8;
+    if (std::memcmp(addr, address.addr, fullBytes) != 0)
+        return false;
+    if (bits % 8 == 0)
+        return true;
+    unsigned char mask = static_cast<unsigned char>(0xff << (8 - bits % 8));
+    return (addr[fullBytes] & mask) == (address.addr[fullBytes] & mask);
+}
+
+bool NetMask::isIPv4() const {
+    return std::memcmp(addr, V4_MAPPED_PREFIX, 12) == 0;
+}
+
+// Shortens the prefix to 'prefix' bits and clears the host bits after it.
+void NetMask::truncate(int prefix) {
+    if (prefix >= bits)
+        return;
+    bits = prefix;
+    int fullBytes = bits / 8;
+    if (bits % 8 != 0) {
+        addr[fullBytes] &= static_cast<unsigned char>(0xff << (8 - bits % 8));
+        fullBytes++;
+    }
+    std::memset(addr + fullBytes, 0, sizeof(addr) - fullBytes);
+}
+
+std::string NetMask::toString() const {
+    char buf[INET6_ADDRSTRLEN];
+    std::ostringstream oss;
+
+    if (bits >= 96 && std::memcmp(addr, V4_MAPPED_PREFIX, 12) == 0) {
+        inet_ntop(AF_INET, addr + 12, buf, sizeof(buf));
+        oss << buf << "/" << (bits - 96);
+    }
+    else {
+        inet_ntop(AF_INET6, addr, buf, sizeof(buf));
+        oss << buf << "/" << bits;
+    }
+    return oss.str();
+}
@@ -17,19 +17,20 @@ bool NickCommand::checkErrors() {
     std::string nick = currentNick.empty() ? "*" : currentNick;
 
     if (!client->isAuthenticated()) {
-        client->sendMessage(ERR_NOTREGISTERED(nick) + "\r\n");
+        client->sendReply(ERR_NOTREGISTERED(nick));
         return true;
     }
     if (params.empty() || params[0].empty()) {
-        client->sendMessage(ERR_NONICKNAMEGIVEN(nick) + "\r\n");
+        client->sendReply(ERR_NONICKNAMEGIVEN(nick));
         return true;
     }
-    if (server->getClientByNick(newNick) != NULL && newNick != currentNick) {
-        client->sendMessage(ERR_NICKNAMEINUSE(newNick) + "\r\n");
+    Client* owner = server->getClientByNick(newNick);
+    if (owner != NULL && owner != client) {
+        client->sendReply(ERR_NICKNAMEINUSE(newNick));
         return true;
     }
     if (newNick.length() > 9) {
-        client->sendMessage(ERR_ERRONEUSNICKNAME(nick, newNick) + "\r\n");
+        client->sendReply(ERR_ERRONEUSNICKNAME(nick, newNick));
         return true;
     }
     return false;
@@ -47,23 +48,15 @@ void NickCommand::execute() {
     client->setNickname(newNick);
     if (client->getNickname() != newNick) {
         std::string nick = oldNick.empty() ? "*" : oldNick;
-        client->sendMessage(ERR_ERRONEUSNICKNAME(nick, newNick) + "\r\n");
+        client->sendReply(ERR_ERRONEUSNICKNAME(nick, newNick));
         return;
     }
+    server->updateNickIndex(client, oldNick);
     
     if (client->isRegistered()) {
         std::string msg = oldPrefix + " NICK :" + newNick + "\r\n";
-        const std::set<Channel*>& channels = client->getChannels();
-
-        client->sendMessage(msg);
-        for (std::set<Channel*>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
-            (*it)->broadcast(msg, client);
-        }
-    }
-    else if (!client->getUsername().empty()) {
-        client->registerClient();
-        client->sendMessage(RPL_WELCOME(newNick, client->getUsername(), client->getHostname()) + "\r\n");
-        client->sendMessage(RPL_YOURHOST(newNick) + "\r\n");
-        client->sendMessage(RPL_MYINFO(newNick) + "\r\n");
+        server->broadcastToNeighbours(client, msg, true);
     }
+    else
+        server->completeRegistration(client);
 }
@@ -0,0 +1,96 @@
+#include "../includes/NumericReply.hpp"
+#include "../includes/Replies.hpp"
+#include <cstring>
+
+// ":ircserv " is the same for every numeric; only the three digits that
+// follow it are written per reply.
+static const char numericPrefix[] = ":" SERVER_NAME " ";
+
+NumericReply::NumericReply(int code, const std::string& target) : len(0) {
+    putCode(code);
+    put(target.data(), target.length());
+}
+
+NumericReply::NumericReply(int code, const char* target) : len(0) {
+    putCode(code);
+    put(target, std::strlen(target));
+}
+
+void NumericReply::putCode(int code) {
+    char digits[4];
+
+    digits[0] = '0' + (code / 100) % 10;
+    digits[1] = '0' + (code / 10) % 10;
+    digits[2] = '0' + code % 10;
+    digits[3] = ' ';
+    put(numericPrefix, sizeof(numericPrefix) - 1);
+    put(digits, 4);
+}
+
+void NumericReply::put(const char* s, size_t n) {
+    if (n > sizeof(buffer) - len)
+        n = sizeof(buffer) - len;
+    std::memcpy(buffer + len, s, n);
+    len += n;
+}
+
+NumericReply& NumericReply::arg(const std::string& s) {
+    put(" ", 1);
+    put(s.data(), s.length());
+    return *this;
+}
+
+NumericReply& NumericReply::arg(const char* s) {
+    put(" ", 1);
+    put(s, std::strlen(s));
+    return *this;
+}
+
+NumericReply& NumericReply::arg(const StringView& s) {
+    put(" ", 1);
+    put(s.data, s.length);
+    return *this;
+}
+
+NumericReply& NumericReply::arg(unsigned long n) {
+    char digits[24];
+    size_t pos = sizeof(digits);
+
+    do {
+        digits[--pos] = '0' + n % 10;
+        n /= 10;
+    } while (n != 0);
+    put(" ", 1);
+    put(digits + pos, sizeof(digits) - pos);
+    return *this;
+}
+
+NumericReply& NumericReply::trailing(const std::string& s) {
+    put(" :", 2);
+    put(s.data(), s.length());
+    return *this;
+}
+
+NumericReply& NumericReply::trailing(const char* s) {
+    put(" :", 2);
+    put(s, std::strlen(s));
+    return *this;
+}
+
+NumericReply& NumericReply::append(const std::string& s) {
+    put(s.data(), s.length());
+    return *this;
+}
+
+NumericReply& NumericReply::append(const char* s) {
+    put(s, std::strlen(s));
+    return *this;
+}
+
+const char* NumericReply::data() const {
+    return buffer;
+}
+
+size_t NumericReply::length() const {
+    return len;
+}
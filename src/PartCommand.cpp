@@ -30,11 +30,11 @@ void PartCommand::execute() {
     std::string nick = client->getNickname();
     if (nick.empty()) nick = "*";
     if (!client->isRegistered()) {
-        client->sendMessage(ERR_NOTREGISTERED(nick) + "\r\n");
+        client->sendReply(ERR_NOTREGISTERED(nick));
         return;
     }
     if (params.empty() || params[0].empty() || params.size() > 2) {
-        client->sendMessage(ERR_NEEDMOREPARAMS(nick, "PART") + "\r\n");
+        client->sendReply(ERR_NEEDMOREPARAMS(nick, "PART"));
         return;
     }
     std::vector<std::string> channelsToPart = split(params[0], ',');
@@ -43,11 +43,11 @@ void PartCommand::execute() {
         std::string channelName = channelsToPart[i];
         Channel* channel = server->getChannel(channelName);
         if (!channel) {
-            client->sendMessage(ERR_NOSUCHCHANNEL(nick, channelName) + "\r\n");
+            client->sendReply(ERR_NOSUCHCHANNEL(nick, channelName));
             continue;
         }
         if (!channel->isMember(client)) {
-            client->sendMessage(ERR_NOTONCHANNEL(nick, channelName) + "\r\n");
+            client->sendReply(ERR_NOTONCHANNEL(nick, channelName));
             continue;
         }
         std::string partMsg = client->getPrefix() + " PART " + channelName;
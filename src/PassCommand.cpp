@@ -16,7 +16,7 @@ void PassCommand::execute() {
     if (nick.empty()) nick = "*";
     
     if (params.size() == 0) {
-        client->sendMessage(ERR_NEEDMOREPARAMS(nick, "PASS") + "\r\n");
+        client->sendReply(ERR_NEEDMOREPARAMS(nick, "PASS"));
         return;
     }
 
@@ -26,7 +26,7 @@ void PassCommand::execute() {
     }
     
     if (client->isRegistered()) {
-        client->sendMessage(ERR_ALREADYREGISTERED(nick) + "\r\n");
+        client->sendReply(ERR_ALREADYREGISTERED(nick));
         return;
     }
     
@@ -37,7 +37,7 @@ void PassCommand::execute() {
     else {
         if (client->isAuthenticated())
             client->unauthenticate();
-        client->sendMessage(ERR_PASSWDMISMATCH(nick) + "\r\n");
+        client->sendReply(ERR_PASSWDMISMATCH(nick));
         return;
     }
 }
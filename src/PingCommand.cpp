@@ -14,7 +14,7 @@ void PingCommand::execute() {
     std::string nick = client->getNickname();
     if (nick.empty()) nick = "*";
     if (params.empty()) {
-        client->sendMessage(ERR_NOORIGIN(nick) + "\r\n");
+        client->sendReply(ERR_NOORIGIN(nick));
         return;
     }
 
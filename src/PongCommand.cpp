@@ -11,7 +11,7 @@ PongCommand::~PongCommand() {
 
 void PongCommand::execute() {
     // PONG is a response to PING from server
-    // When client sends PONG, we just acknowledge it (no response needed)
-    // This resets the client's idle timer if implemented
+    // No reply is needed: every line received, this one included, already
+    // refreshed the client's activity time (see Server::handleKeepalive)
     (void)params;  // Unused for now
 }
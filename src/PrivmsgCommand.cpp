@@ -1,63 +1,113 @@
 #include "../includes/PrivmsgCommand.hpp"
 #include "../includes/Channel.hpp"
+#include "../includes/SharedMessage.hpp"
 #include "../includes/Replies.hpp"
 
 PrivmsgCommand::PrivmsgCommand(Server* srv, Client* cli, const std::vector<std::string>& params)
-    : Command(srv, cli, params) {
+    : Command(srv, cli, params), verb("PRIVMSG"), quiet(false) {
 }
 
-PrivmsgCommand::~PrivmsgCommand() {
+PrivmsgCommand::PrivmsgCommand(Server* srv, Client* cli, const std::vector<std::string>& params,
+                               const char* verb, bool quiet)
+    : Command(srv, cli, params), verb(verb), quiet(quiet) {
 }
 
-static std::vector<std::string> split(const std::string& str, char delimiter) {
-    std::vector<std::string> tokens;
-    size_t start = 0;
-    size_t end = str.find(delimiter);
-    while (end != std::string::npos) {
-        tokens.push_back(str.substr(start, end - start));
-        start = end + 1;
-        end = str.find(delimiter, start);
-    }
-    tokens.push_back(str.substr(start));
-    return tokens;
+PrivmsgCommand::~PrivmsgCommand() {
 }
 
-void    PrivmsgCommand::executeSingle(const std::string &receptor) {
-    if (receptor[0] == '#' || receptor[0] == '&') {
-        if (!this->server->channelExistOrNot(receptor)) {
-            this->client->sendMessage(ERR_NOSUCHCHANNEL(this->client->getNickname(), receptor) + "\r\n");
-            return;
+// Looks target up as a channel or a nickname. Returns false, after the
+// matching error reply, when the message cannot be delivered there.
+bool    PrivmsgCommand::resolveTarget(const StringView& target, Channel*& channel, Client*& user) {
+    channel = NULL;
+    user = NULL;
+    if (target.data[0] == '#' || target.data[0] == '&') {
+        channel = this->server->getChannel(target);
+        if (channel == NULL) {
+            if (!quiet)
+                this->client->sendReply(ERR_NOSUCHCHANNEL(this->client->getNickname(), target));
+            return (false);
         }
-        Channel* channel = this->server->getOrCreateChannel(receptor);
         if (!channel->isMember(this->client)) {
-            this->client->sendMessage(ERR_CANNOTSENDTOCHAN(this->client->getNickname(), receptor) + "\r\n");
-            return;
+            if (!quiet)
+                this->client->sendReply(ERR_CANNOTSENDTOCHAN(this->client->getNickname(), target));
+            return (false);
         }
-        channel->broadcast(this->client->getPrefix() + " PRIVMSG " + receptor + " " + this->params[1] + "\r\n", this->client);
+        return (true);
     }
-    else
-    {
-        Client *targetClient = this->server->getClientByNick(receptor);
-        if (targetClient == NULL) {
-            this->client->sendMessage(ERR_NOSUCHNICK(this->client->getNickname(), receptor) + "\r\n");
-            return;
-        }
-        targetClient->sendMessage(this->client->getPrefix() + " PRIVMSG " + receptor + " " + this->params[1] + "\r\n");
+    user = this->server->getClientByNick(target);
+    if (user == NULL) {
+        if (!quiet)
+            this->client->sendReply(ERR_NOSUCHNICK(this->client->getNickname(), target));
+        return (false);
     }
+    return (true);
 }
 
 void PrivmsgCommand::execute() {
     if (!this->client->isRegistered()) {
-        this->client->sendMessage(ERR_NOTREGISTERED(this->client->getNickname()) + "\r\n");
+        if (!quiet)
+            this->client->sendReply(ERR_NOTREGISTERED(this->client->getNickname()));
         return;
     }
-    if (this->params.size() < 2) {
-        this->client->sendMessage(ERR_NEEDMOREPARAMS(this->client->getNickname(), "PRIVMSG") + "\r\n");
+    if (this->params.empty() || this->params[0].empty()) {
+        if (!quiet)
+            this->client->sendReply(ERR_NORECIPIENT(this->client->getNickname(), verb));
         return;
     }
-    std::vector<std::string> receptors = split(this->params[0], ',');
-    for (std::vector<std::string>::iterator it = receptors.begin(); it != receptors.end(); ++it) {
-        executeSingle(*it);
+    if (this->params.size() < 2 || this->params[1].empty() || this->params[1] == ":") {
+        if (!quiet)
+            this->client->sendReply(ERR_NOTEXTTOSEND(this->client->getNickname()));
+        return;
     }
 
+    // "<prefix> <verb> " and " <text>\r\n" are the same for every target;
+    // line keeps its capacity while the target between them is swapped.
+    const std::string& targets = this->params[0];
+    std::string head = this->client->getPrefix() + " " + verb + " ";
+    std::string tail = " " + this->params[1] + "\r\n";
+    std::string line;
+    line.reserve(head.length() + targets.length() + tail.length());
+
+    void* seen[MAX_TARGETS];
+    size_t count = 0;
+    size_t processed = 0;
+    size_t start = 0;
+    while (start <= targets.length()) {
+        size_t end = targets.find(',', start);
+        if (end == std::string::npos)
+            end = targets.length();
+        StringView target(targets.data() + start, end - start);
+        start = end + 1;
+        if (target.empty())
+            continue;
+        if (processed++ == MAX_TARGETS) {
+            if (!quiet)
+                this->client->sendReply(ERR_TOOMANYTARGETS(this->client->getNickname(), target));
+            break;
+        }
+
+        Channel* channel;
+        Client* user;
+        if (!resolveTarget(target, channel, user))
+            continue;
+        void* key = channel ? static_cast<void*>(channel) : static_cast<void*>(user);
+        size_t i = 0;
+        while (i < count && seen[i] != key)
+            i++;
+        if (i < count)
+            continue;
+        seen[count++] = key;
+
+        line.assign(head);
+        line.append(target.data, target.length);
+        line.append(tail);
+        if (channel != NULL) {
+            SharedMessage* shared = SharedMessage::create(line, true);
+            channel->broadcast(shared, this->client);
+            shared->release();
+            this->server->recordHistory(channel, line, this->params[1]);
+        }
+        else
+            user->sendMessage(line);
+    }
 }
@@ -16,17 +16,14 @@ void QuitCommand::execute() {
     std::string quitMsg;
 
     if (params.empty()) {
-        quitMsg = USER_PREFIX(client->getNickname(), 
-                              client->getUsername(), "unknown.host") + " QUIT\r\n";
+        quitMsg = client->getPrefix() + " QUIT\r\n";
     }
     else {
         std::string msg = params[0];
         if (params[0][0] == ':') {
             msg = params[0].substr(1);
         }
-        quitMsg = USER_PREFIX(client->getNickname(), 
-                              client->getUsername(), "unknown.host") + " QUIT :" + 
-                  msg + "\r\n";
+        quitMsg = client->getPrefix() + " QUIT :" + msg + "\r\n";
     }    
     
     server->broadcastQuitNotification(client, quitMsg);
@@ -0,0 +1,62 @@
+#include "../includes/SearchCommand.hpp"
+#include "../includes/Server.hpp"
+#include "../includes/Client.hpp"
+#include "../includes/Channel.hpp"
+#include "../includes/Replies.hpp"
+#include <cstdlib>
+
+SearchCommand::SearchCommand(Server* srv, Client* cli, const std::vector<std::string>& params)
+    : Command(srv, cli, params) {
+}
+
+SearchCommand::~SearchCommand() {
+}
+
+void SearchCommand::fail(const char* code, const std::string& context, const char* description) {
+    client->sendMessage(":" SERVER_NAME " FAIL SEARCH " + std::string(code) + " "
+                        + context + " :" + description + "\r\n");
+}
+
+// SEARCH <channel> <limit> :<words>
+// Replays the newest <limit> lines of the channel's history that contain
+// every word, oldest first, framed like a CHATHISTORY reply ("search"
+// batch for clients that enabled message-tags and batch). Matching
+// ignores case.
+void SearchCommand::execute() {
+    if (!client->isRegistered()) {
+        client->sendReply(ERR_NOTREGISTERED(client->getNickname()));
+        return;
+    }
+    if (params.size() < 3) {
+        client->sendReply(ERR_NEEDMOREPARAMS(client->getNickname(), "SEARCH"));
+        return;
+    }
+
+    const std::string& target = params[0];
+    Channel* channel = server->getChannel(target);
+    if (channel == NULL || !channel->isMember(client)) {
+        fail("INVALID_TARGET", target, "Messages could not be retrieved");
+        return;
+    }
+    char* end;
+    unsigned long limit = std::strtoul(params[1].c_str(), &end, 10);
+    if (params[1].empty() || *end != '\0' || limit == 0) {
+        fail("INVALID_PARAMS", params[1], "Invalid limit");
+        return;
+    }
+    if (limit > HISTORY_REPLAY_MAX)
+        limit = HISTORY_REPLAY_MAX;
+
+    ChannelHistory& history = channel->getHistory();
+    std::vector<size_t> positions;
+    history.search(params[2], limit, positions);
+
+    bool tagged = client->hasCaps(CAP_MESSAGE_TAGS | CAP_BATCH);
+    if (tagged)
+        client->sendMessage(":" SERVER_NAME " BATCH +" HISTORY_BATCH " search " + channel->getName() + "\r\n");
+    for (size_t i = 0; i < positions.size(); i++)
+        history.replay(client, positions[i], positions[i] + 1, tagged);
+    if (tagged)
+        client->sendMessage(":" SERVER_NAME " BATCH -" HISTORY_BATCH "\r\n");
+    server->touchHistory(channel);
+}
@@ -1,27 +1,54 @@
 #include "../includes/Server.hpp"
 #include "../includes/Client.hpp"
 #include "../includes/Channel.hpp"
+#include "../includes/SharedMessage.hpp"
 #include "../includes/MessageParser.hpp"
 #include "../includes/Command.hpp"
+#include "../includes/Replies.hpp"
 #include <sys/time.h>
 #include <csignal>
 #include <ctime>
 #include <vector>
 #include <iostream>
+#include <sstream>
 #include <sys/socket.h>
 #include <netinet/in.h> 
 #include <arpa/inet.h> 
+#include <fcntl.h>
+#include <cerrno>
 #include "../includes/Command.hpp"
 
 volatile sig_atomic_t g_running = 1;
+volatile sig_atomic_t g_reload = 0;
+
+#define MAX_EVENTS 64
+#define MAX_ACCEPTS_PER_EVENT 64
+#define MAX_READS_PER_EVENT 8
+
+// Timer wheel granularity and connection timeouts (in seconds)
+#define TIMER_TICK_MS 100
+#define REGISTRATION_TIMEOUT 60
+#define PING_INTERVAL 120
+#define PING_TIMEOUT 60
+#define SECONDS_TO_TICKS(s) ((s) * 1000UL / TIMER_TICK_MS)
+
+static unsigned long monotonicMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (static_cast<unsigned long>(ts.tv_sec) * 1000UL + ts.tv_nsec / 1000000);
+}
 
 
-Server::Server(int port, const std::string &password) : port(port), password(password), serverSocket(-1) {
+Server::Server(int port, const std::string &password, const Config& config)
+    : port(port), password(password), config(config), serverSocket(-1), epollFd(-1),
+    flushCount(0), flushedMessages(0), neighbourEpoch(0), historyIds(0), historyClockMs(0),
+    historyBytes(0) {
     this->running = false;
+    loadBans();
 }
 Server::~Server() {
     std::map <int, Client*>::iterator it;
-    std::map <std::string, Channel*>::iterator itc;
+    std::vector<Channel*> allChannels;
     
     for (it = clients.begin() ; it != clients.end() ; it++) {
         close (it->first);
@@ -29,14 +56,17 @@ Server::~Server() {
     }
     clients.clear();
 
-    for (itc = channels.begin()  ; itc != channels.end()  ; itc++) {
-        delete (itc->second);
+    channels.values(allChannels);
+    for (size_t i = 0 ; i < allChannels.size() ; i++) {
+        delete (allChannels[i]);
     }
-    channels.clear();
 
     if (serverSocket != -1) {
         close (serverSocket);
     }
+    if (epollFd != -1) {
+        close (epollFd);
+    }
 }
 
 void signalHandler(int signum) {
@@ -44,6 +74,11 @@ void signalHandler(int signum) {
     g_running = 0;
 }
 
+void reloadHandler(int signum) {
+    (void) signum;
+    g_reload = 1;
+}
+
 void Server::start() {
     int errorFlag = setupSocket();
 
@@ -51,12 +86,18 @@ void Server::start() {
         return;
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+    signal(SIGHUP, reloadHandler);
 
+    timers.reset(monotonicMs() / TIMER_TICK_MS);
     this->running = true;
     g_running = 1;
     while (running && g_running)
     {
-        handleSelect();
+        if (g_reload) {
+            g_reload = 0;
+            reloadBans();
+        }
+        handleEvents();
     }
     stop();
 }
@@ -72,9 +113,10 @@ void Server::stop() {
     
     for (it = clients.begin()  ; it != clients.end()  ;  it++) {
         int clientFd = it->first;
+        Client* client = it->second;
 
-        int sent = send(clientFd, exitMessage.c_str(), exitMessage.length(), 0);
-        if (sent > 0)
+        client->sendMessage(exitMessage);
+        if (client->flushOutput() == 0 && !client->hasPendingOutput())
             std::cout << "  [OK] Shutdown message sent to FD: " << clientFd << std::endl;
         else
             std::cout << "  [!!] Failed to send shutdown to FD: " << clientFd << std::endl;
@@ -87,6 +129,10 @@ void Server::stop() {
     if (serverSocket != -1)
         close(serverSocket);
 
+    std::cout << "\n  Output flushes: " << flushCount << " | Messages flushed: " << flushedMessages;
+    if (flushCount > 0)
+        std::cout << " | Messages per flush: " << (double)flushedMessages / flushCount;
+    std::cout << std::endl;
     std::cout << "\n  All connections closed. Server stopped." << std::endl;
     std::cout << "════════════════════════════════════════════\n" << std::endl;
     this->running = false;
@@ -120,13 +166,13 @@ int Server::setupBind() {
 }
 
 int Server::setupListen() {
-    int listenResult = listen(serverSocket, 10);
+    int listenResult = listen(serverSocket, config.getListenBacklog());
     if (listenResult == -1) {
         std::cerr << "[ERROR] Failed to listen on port " << this->port << std::endl;
         close (serverSocket);
         return (1);
     }
-    std::cout << "  [OK] Listening (backlog: 10)" << std::endl;
+    std::cout << "  [OK] Listening (backlog: " << config.getListenBacklog() << ")" << std::endl;
     return (0);
 }
 
@@ -146,12 +192,20 @@ int Server::setupSocket() {
    
     int opt = 1;
     setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (!setNonBlocking(serverSocket)) {
+        std::cerr << "[ERROR] Failed to set server socket non-blocking" << std::endl;
+        close (serverSocket);
+        return (1);
+    }
 
     if (setupBind() == 1)
         return (1);
 
     if (setupListen() == 1)
         return (1);
+
+    if (setupEpoll() == 1)
+        return (1);
     
     std::cout << "\n════════════════════════════════════════════" << std::endl;
     std::cout << "  Server ready on port " << this->port << std::endl;
@@ -160,19 +214,111 @@ int Server::setupSocket() {
     return (0);
 }
 
-int Server::prepareSelectFds(fd_set& readfds) {
-    FD_ZERO(&readfds);
-    FD_SET(serverSocket, &readfds);
-    
-    int maxFd = serverSocket;
-    std::map<int, Client*>::iterator it;
-    for (it = clients.begin() ; it != clients.end() ; it++) {
-        int fd = it->first;
-        FD_SET(fd, &readfds);
-        if (fd > maxFd)
-            maxFd = fd;
+int Server::setupEpoll() {
+    epollFd = epoll_create1(0);
+    if (epollFd == -1) {
+        std::cerr << "[ERROR] Failed to create epoll instance" << std::endl;
+        close (serverSocket);
+        return (1);
     }
-    return maxFd;
+    if (!watchFd(serverSocket)) {
+        std::cerr << "[ERROR] Failed to register server socket in epoll" << std::endl;
+        close (serverSocket);
+        return (1);
+    }
+    std::cout << "  [OK] Epoll instance created (FD: " << epollFd << ")" << std::endl;
+    return (0);
+}
+
+bool Server::watchFd(int fd) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1)
+        return (false);
+    return (true);
+}
+
+void Server::unwatchFd(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+bool Server::setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags == -1)
+        return (false);
+    if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        return (false);
+    return (true);
+}
+
+// Syncs the epoll registration with the client's state: EPOLLIN unless
+// reading is paused for flood control, EPOLLOUT while output is pending.
+void Server::updateInterest(Client* client) {
+    struct epoll_event ev;
+    ev.events = 0;
+    if (!client->isReadPaused())
+        ev.events |= EPOLLIN;
+    if (client->isWriteWatched())
+        ev.events |= EPOLLOUT;
+    ev.data.fd = client->getFd();
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, client->getFd(), &ev);
+}
+
+// Called whenever output is queued for a client. Output is only written
+// once per loop iteration (see flushPendingClients), so a join burst or a
+// run of replies leaves in one sendmsg() instead of one send() per line.
+// A client already waiting for EPOLLOUT is flushed by handleClientWrite.
+void Server::scheduleFlush(Client* client) {
+    if (client == NULL || client->isFlushScheduled() || client->isWriteWatched())
+        return;
+    client->setFlushScheduled(true);
+    pendingFlush.push_back(client->getFd());
+}
+
+// Called by a client whose send queue would exceed its class sendq_max.
+// The client cannot be dropped in the middle of a broadcast, so the
+// eviction runs from flushPendingClients at the end of the iteration.
+void Server::evictClient(Client* client) {
+    pendingEvictions.push_back(client->getFd());
+}
+
+void Server::flushPendingClients() {
+    for (size_t i = 0; i < pendingEvictions.size(); i++) {
+        // The evicted client may have disconnected since and its fd been
+        // handed to a new connection; only a client that actually hit
+        // sendq_max is closed.
+        std::map<int, Client*>::iterator it = clients.find(pendingEvictions[i]);
+        if (it == clients.end() || !it->second->isSendqExceeded())
+            continue;
+        Client* client = it->second;
+        std::cout << "  [!!] SendQ exceeded for FD " << client->getFd() << " ("
+                  << client->getSendQueueBytes() << " bytes queued, "
+                  << client->getDroppedMessages() << " messages dropped)" << std::endl;
+        closeLink(client, "SendQ exceeded");
+    }
+    pendingEvictions.clear();
+
+    for (size_t i = 0; i < pendingFlush.size(); i++) {
+        int fd = pendingFlush[i];
+        std::map<int, Client*>::iterator it = clients.find(fd);
+        if (it == clients.end())
+            continue;
+        Client* client = it->second;
+        client->setFlushScheduled(false);
+
+        flushCount++;
+        flushedMessages += client->getQueuedSinceFlush();
+        if (client->flushOutput() == -1) {
+            disconnectClient(fd);
+            continue;
+        }
+        if (client->hasPendingOutput() && !client->isWriteWatched()) {
+            client->setWriteWatched(true);
+            updateInterest(client);
+        }
+    }
+    pendingFlush.clear();
 }
 
 void Server::displayIdleAnimation() {
@@ -192,53 +338,154 @@ void Server::displayIdleAnimation() {
     }
 }
 
-void Server::processReadyClients(fd_set& readfds) {
-    if (FD_ISSET(serverSocket, &readfds))
-        acceptNewClient();
-    
-    std::vector<int> readyFds;
-    std::map<int, Client*>::iterator it;
-    for (it = clients.begin() ; it != clients.end() ; it++) {
-        int fd = it->first;
-        if (FD_ISSET(fd, &readfds))
-            readyFds.push_back(fd);
-    }
-    
-    for (size_t i = 0; i < readyFds.size(); i++) {
-        int fd = readyFds[i];
-        if (clients.find(fd) != clients.end())
+void Server::processReadyClients(struct epoll_event* events, int count) {
+    bool listenerReady = false;
+
+    for (int i = 0; i < count; i++) {
+        int fd = events[i].data.fd;
+        if (fd == serverSocket) {
+            listenerReady = true;
+            continue;
+        }
+        std::map<int, Client*>::iterator it = clients.find(fd);
+        if (it == clients.end())
+            continue;
+        // A client paused for flood control can still report a stale
+        // EPOLLIN from this batch, or a hangup, which epoll always reports.
+        if (it->second->isReadPaused()) {
+            if (events[i].events & (EPOLLHUP | EPOLLERR))
+                disconnectClient(fd);
+        }
+        else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
             handleClientMessage(fd);
+        if ((events[i].events & EPOLLOUT) && clients.find(fd) != clients.end())
+            handleClientWrite(fd);
+    }
+    // Accept last so a fd freed earlier in this batch cannot be reused
+    // by a new client and then receive a stale event meant for the old one.
+    if (listenerReady) {
+        for (int i = 0; i < MAX_ACCEPTS_PER_EVENT; i++) {
+            if (!acceptNewClient())
+                break;
+        }
     }
 }
 
-void Server::handleSelect() {
-    fd_set readfds;
-    int maxFd = prepareSelectFds(readfds);
-    
-    struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
+// Sleeps until the next event or the next due timer, whichever is first.
+int Server::computeTimeout() {
+    if (timers.size() == 0)
+        return (1000);
+    unsigned long wakeMs = (timers.getCurrent() + timers.ticksUntilNext()) * TIMER_TICK_MS;
+    unsigned long nowMs = monotonicMs();
+    if (wakeMs <= nowMs)
+        return (0);
+    if (wakeMs - nowMs > 1000)
+        return (1000);
+    return static_cast<int>(wakeMs - nowMs);
+}
 
-    int selectResult = select(maxFd + 1, &readfds, NULL, NULL, &timeout);
+void Server::handleEvents() {
+    struct epoll_event events[MAX_EVENTS];
 
-    if (selectResult == -1) {
+    int eventCount = epoll_wait(epollFd, events, MAX_EVENTS, computeTimeout());
+
+    if (eventCount == -1 && errno != EINTR) {
         return;
     }
-    if (selectResult == 0) {
+    if (eventCount > 0)
+        processReadyClients(events, eventCount);
+    else
         displayIdleAnimation();
+    runTimers();
+    flushPendingClients();
+}
+
+// Both timers of one client can expire in the same batch, and either
+// callback may free the client. So every node is turned into (fd, kind)
+// before any callback runs, and the client is looked up again each time.
+void Server::runTimers() {
+    std::vector<TimerNode*> expired;
+    std::vector<std::pair<int, bool> > due;
+
+    timers.advance(monotonicMs() / TIMER_TICK_MS, expired);
+    for (size_t i = 0; i < expired.size(); i++) {
+        std::map<int, Client*>::iterator it = clients.find(expired[i]->fd);
+        if (it == clients.end())
+            continue;
+        bool isFloodTimer = (expired[i] == it->second->getFloodTimer());
+        due.push_back(std::make_pair(expired[i]->fd, isFloodTimer));
+    }
+    for (size_t i = 0; i < due.size(); i++) {
+        std::map<int, Client*>::iterator it = clients.find(due[i].first);
+        if (it == clients.end())
+            continue;
+        if (due[i].second)
+            resumeClient(it->second);
+        else
+            handleKeepalive(it->second);
+    }
+}
+
+// One timer per connection drives its whole lifecycle: the registration
+// deadline, then a PING once the client has been silent for
+// PING_INTERVAL, then a disconnect if nothing arrives within PING_TIMEOUT.
+// Activity is only recorded on read; the timer checks it lazily when it
+// fires instead of being rescheduled for every line.
+void Server::handleKeepalive(Client* client) {
+    unsigned long now = timers.getCurrent();
+    TimerNode* timer = client->getKeepaliveTimer();
+
+    if (!client->isRegistered()) {
+        closeLink(client, "Registration timeout");
+        return;
+    }
+    if (client->isAwaitingPong()) {
+        closeLink(client, "Ping timeout");
+        return;
+    }
+    unsigned long idleUntil = client->getLastActivity() + SECONDS_TO_TICKS(PING_INTERVAL);
+    if (idleUntil > now) {
+        timers.schedule(timer, idleUntil);
         return;
     }
-    processReadyClients(readfds);
+    client->sendMessage("PING :" SERVER_NAME "\r\n");
+    client->setAwaitingPong(true);
+    timers.schedule(timer, now + SECONDS_TO_TICKS(PING_TIMEOUT));
 }
 
-void Server::acceptNewClient() {
+// Stops reading from a client whose fake lag ran over its burst; the
+// lines it already sent stay buffered, and the kernel's receive buffer
+// and TCP flow control hold back the rest.
+void Server::pauseClient(Client* client) {
+    if (!client->isReadPaused()) {
+        client->setReadPaused(true);
+        updateInterest(client);
+    }
+    timers.schedule(client->getFloodTimer(),
+                    (client->getFloodResumeMs() + TIMER_TICK_MS - 1) / TIMER_TICK_MS);
+}
+
+void Server::resumeClient(Client* client) {
+    if (!processClientLines(client))
+        return;
+    client->setReadPaused(false);
+    updateInterest(client);
+}
+
+// Accepts one pending connection. Returns false once the backlog is
+// drained, so a single wakeup can take a whole burst of connections.
+bool Server::acceptNewClient() {
     struct  sockaddr_in clientAddr;
     socklen_t   clientLen = sizeof(clientAddr);
 
-    int clientFd = accept(serverSocket, (struct sockaddr*)&clientAddr, &clientLen);
+    int clientFd = accept4(serverSocket, (struct sockaddr*)&clientAddr, &clientLen,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
     if (clientFd == -1) {
-        std::cerr << "  [!!] Failed to accept new client" << std::endl;
-        return;
+        if (errno == EINTR || errno == ECONNABORTED)
+            return (true);
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            std::cerr << "  [!!] Failed to accept new client" << std::endl;
+        return (false);
     }
     
     char clientIP[INET_ADDRSTRLEN];
@@ -246,13 +493,86 @@ void Server::acceptNewClient() {
     
     int clientPort = ntohs(clientAddr.sin_port);
     
-    Client* newClient = new Client(clientFd);
+    NetMask clientMask;
+    NetMask::fromSockaddr(reinterpret_cast<struct sockaddr*>(&clientAddr), clientMask);
+    const std::string* banReason = bans.match(clientMask);
+    if (banReason != NULL) {
+        rejectConnection(clientFd, clientIP, "D-lined: " + *banReason);
+        return (true);
+    }
+    const ConnectionClass& cls = config.findClass(clientMask);
+    NetMask source = ConnectionThrottle::sourceOf(clientMask, cls);
+    ConnectionThrottle::Verdict verdict = throttle.admit(source, cls, monotonicMs());
+    bool counted = (verdict == ConnectionThrottle::ADMITTED);
+    if (!counted && verdict != ConnectionThrottle::EXEMPT) {
+        rejectConnection(clientFd, clientIP, verdict == ConnectionThrottle::TOO_FAST
+                         ? "Connecting too fast" : "Too many connections from your host");
+        return (true);
+    }
+
+    if (!watchFd(clientFd)) {
+        std::cerr << "  [!!] Failed to register FD " << clientFd << " in epoll" << std::endl;
+        if (counted)
+            throttle.release(source);
+        close (clientFd);
+        return (true);
+    }
+
+    Client* newClient = new Client(clientFd, this);
     clients[clientFd] = newClient;
+    newClient->setAddress(clientIP);
+    newClient->setSource(source, counted);
+    newClient->setConnectionClass(&cls);
+    newClient->touch(timers.getCurrent());
+    timers.schedule(newClient->getKeepaliveTimer(),
+                    timers.getCurrent() + SECONDS_TO_TICKS(REGISTRATION_TIMEOUT));
     std::cout << "\n  [+] New client connected" << std::endl;
     std::cout << "      FD: " << clientFd << " | IP: " << clientIP << ":" << clientPort << std::endl;
 
-    std::string welcome = ":Server ft_irc :Welcome to the IRC Server\r\n";
-    send (clientFd, welcome.c_str(), welcome.length(), 0);
+    newClient->sendMessage(":Server ft_irc :Welcome to the IRC Server\r\n");
+    return (true);
+}
+
+// Turns away a connection refused by the throttle without allocating
+// anything for it: one best-effort ERROR line, then close.
+void Server::rejectConnection(int fd, const char* ip, const std::string& reason) {
+    std::string msg = "ERROR :Closing Link: " + std::string(ip) + " (" + reason + ")\r\n";
+    send(fd, msg.data(), msg.length(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    close (fd);
+    std::cout << "  [-] Rejected connection from " << ip << " (" << reason << ")" << '\n';
+}
+
+// Reads the D-line file named in the config into a fresh trie and swaps
+// it in; a malformed file throws and leaves the current bans in place.
+void Server::loadBans() {
+    if (config.getDlineFile().empty())
+        return;
+    BanTrie fresh;
+    fresh.loadFile(config.getDlineFile());
+    bans.swap(fresh);
+    std::cout << "  [OK] Loaded " << bans.size() << " D-lines" << std::endl;
+}
+
+// SIGHUP: re-reads the D-line file and drops connected clients that the
+// new bans cover.
+void Server::reloadBans() {
+    try {
+        loadBans();
+    } catch (const std::exception& e) {
+        std::cerr << "  [!!] D-line reload failed: " << e.what() << std::endl;
+        return;
+    }
+    std::vector<Client*> banned;
+    for (std::map<int, Client*>::iterator it = clients.begin(); it != clients.end(); ++it) {
+        NetMask address;
+        if (NetMask::parse(it->second->getAddress(), address) && bans.match(address) != NULL)
+            banned.push_back(it->second);
+    }
+    for (size_t i = 0; i < banned.size(); i++) {
+        NetMask address;
+        NetMask::parse(banned[i]->getAddress(), address);
+        closeLink(banned[i], "D-lined: " + *bans.match(address));
+    }
 }
 
 void Server::handleClientMessage(int fd) {
@@ -262,29 +582,91 @@ void Server::handleClientMessage(int fd) {
         return;
     }
     Client* client = it->second;
-    char buffer[512];
-    int byteReceived = recv(fd, buffer, sizeof(buffer) -  1, 0);
-    
-    if (byteReceived == 0) {
+
+    // Read straight into the client's input buffer until the socket is
+    // drained (a short read) or the per-event budget is spent;
+    // level-triggered epoll reports the rest next round.
+    for (int reads = 0; reads < MAX_READS_PER_EVENT; reads++) {
+        char* space;
+        size_t room = client->prepareRead(space);
+        ssize_t byteReceived = recv(fd, space, room, 0);
+
+        if (byteReceived == 0) {
+            disconnectClient(fd);
+            return;
+        }
+        if (byteReceived == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                disconnectClient(fd);
+            return;
+        }
+        client->commitRead(byteReceived);
+        client->touch(timers.getCurrent());
+
+        if (!processClientLines(client))
+            return;
+        if (static_cast<size_t>(byteReceived) < room)
+            return;
+    }
+}
+
+// Runs the complete lines buffered for a client, charging each one's
+// cost to its fake-lag clock. Returns false when the client was
+// disconnected, or paused because it ran over its flood burst.
+bool Server::processClientLines(Client* client) {
+    int fd = client->getFd();
+    unsigned long now = monotonicMs();
+    StringView line;
+
+    while (true) {
+        if (client->isFlooding(now)) {
+            pauseClient(client);
+            return (false);
+        }
+        if (!client->extractLine(line))
+            return (true);
+        if (line.empty())
+            continue;
+        // No flush here: std::endl would cost one write() per command line.
+        std::cout << "  [CMD] ";
+        std::cout.write(line.data, line.length) << '\n';
+        unsigned int cost = executeCommand(client, line);
+        if (clients.find(fd) == clients.end())
+            return (false);
+        client->chargeFlood(cost, now);
+    }
+}
+
+void Server::handleClientWrite(int fd) {
+    std::map<int, Client*>::iterator it = clients.find(fd);
+    if (it == clients.end())
+        return;
+    Client* client = it->second;
+
+    flushCount++;
+    flushedMessages += client->getQueuedSinceFlush();
+    if (client->flushOutput() == -1) {
         disconnectClient(fd);
         return;
     }
-    if (byteReceived == -1) {
-        return;
+    if (!client->hasPendingOutput()) {
+        client->setWriteWatched(false);
+        updateInterest(client);
     }
-    buffer[byteReceived] = '\0';
-    client->appendToBuffer(std::string(buffer, byteReceived));
+}
 
-    std::string command;
-    while ((command = client->extractCommand()) != "") {
-        std::cout << "  [CMD] " << command << std::endl;
-        executeCommand(client, command);
-        if (clients.find(fd) == clients.end())
-            return;
-    }
+void Server::closeLink(Client* client, const std::string& reason) {
+    std::string error = "ERROR :Closing Link: " + client->getHostname() + " (" + reason + ")\r\n";
+    if (client->isSendqExceeded())
+        client->abortOutput(error);
+    else
+        client->sendMessage(error);
+    disconnectClient(client->getFd(), reason);
 }
 
-void Server::disconnectClient(int fd) {
+void Server::disconnectClient(int fd, const std::string& reason) {
     std::map<int, Client*>::iterator it = clients.find(fd);
     if (it == clients.end()) {
         std::cerr << "  [!!] Cannot disconnect: FD " << fd << " not found" << std::endl;
@@ -295,47 +677,39 @@ void Server::disconnectClient(int fd) {
     if (nickname.empty())
         nickname = "Unkown";
 
-    std::string quitMess = client->getPrefix() + " QUIT :Client disconnected\r\n";
-
-    std::vector<std::string> channelNames;
-    std::map<std::string, Channel*>::iterator itc;
-    for (itc = channels.begin() ; itc != channels.end() ; itc++) {
-        if (itc->second->isMember(client)) {
-            channelNames.push_back(itc->first);
-        }
-    }
-    
-    for (size_t i = 0; i < channelNames.size(); i++) {
-        std::map<std::string, Channel*>::iterator found = channels.find(channelNames[i]);
-        if (found != channels.end()) {
-            found->second->broadcast(quitMess, client);
-            found->second->removeMember(client);
-        }
-    }
+    std::string quitMess = client->getPrefix() + " QUIT :" + reason + "\r\n";
+
+    broadcastQuitNotification(client, quitMess);
+    if (nicknames.find(client->getNickname()) == client)
+        nicknames.erase(client->getNickname());
+    timers.cancel(client->getKeepaliveTimer());
+    timers.cancel(client->getFloodTimer());
+    if (client->isSourceCounted())
+        throttle.release(client->getSource());
+    client->flushOutput();
+    unwatchFd(fd);
     close (fd);
     delete client;
     clients.erase(it);
-    std::cout << "  [-] Client disconnected (FD: " << fd << ", Nick: " << nickname << ")" << std::endl;
+    std::cout << "  [-] Client disconnected (FD: " << fd << ", Nick: " << nickname
+              << ", Reason: " << reason << ")" << std::endl;
 }
 
-std::string Server::toLower(const std::string& str) {
-    std::string result = str;
-    for (size_t i = 0 ; i < result.length() ; i++) {
-        result[i] = std::tolower(result[i]);
-    }
-    return (result);
+Client* Server::getClientByNick(const std::string& nick) {
+    return (nicknames.find(nick));
 }
 
-Client* Server::getClientByNick(const std::string& nick) {
-    std::map<int, Client*>::iterator it;
-    std::string lowerNick = toLower(nick);
-    for (it = clients.begin() ; it != clients.end() ; it++) {
-        Client* client = it->second;
-        if (toLower(client->getNickname()) == lowerNick) {
-            return (client);
-        }
-    }
-    return (NULL);
+Client* Server::getClientByNick(const StringView& nick) {
+    return (nicknames.find(nick.data, nick.length));
+}
+
+// Moves a client's entry in the nickname index after its nickname was
+// set; oldNick is the nickname it had before (empty on first NICK).
+void    Server::updateNickIndex(Client* client, const std::string& oldNick) {
+    if (!oldNick.empty() && nicknames.find(oldNick) == client)
+        nicknames.erase(oldNick);
+    if (!client->getNickname().empty())
+        nicknames.insert(client->getNickname(), client);
 }
 
 bool    Server::isValidName(const std::string& src) {
@@ -358,99 +732,160 @@ bool    Server::isValidName(const std::string& src) {
 }
 
 Channel* Server::getOrCreateChannel(const std::string& name) {
-    std::map<std::string, Channel*>::iterator it;
-    std::string lowerName = toLower(name);
-    for (it = channels.begin() ; it != channels.end() ; it++) {
-        Channel* channel = it->second;
-        if (toLower(channel->getName()) ==  lowerName) {
-            return (channel);
-        }
+    Channel* channel = channels.find(name);
+    if (channel != NULL) {
+        return (channel);
     }
-    if (isValidName(lowerName) == false)  {
+    if (isValidName(name) == false)  {
         return (NULL);
     }
     Channel* newChannel = new Channel(name, this);
-    channels[lowerName] = newChannel;
+    channels.insert(newChannel->getFoldedName(), newChannel);
     return (newChannel);
 }
 
-void Server::executeCommand(Client* client, const std::string& cmd) {
-    Command* command = MessageParser::parse(cmd, this, client);
-    if (command == NULL) {
-        return;
-    }
-    command->execute();
-    delete command;
+unsigned int Server::executeCommand(Client* client, const StringView& line) {
+    return (MessageParser::dispatch(line, this, client));
 }
 
 const std::string& Server::getPassword() {
     return (password);
 }
 
+// Registers client and sends the welcome burst once NICK and USER have
+// both been given and capability negotiation, if it was started, ended.
+void    Server::completeRegistration(Client* client) {
+    if (client->isRegistered() || client->isCapNegotiating()
+        || client->getNickname().empty() || client->getUsername().empty())
+        return;
+    const std::string& nick = client->getNickname();
+    client->registerClient();
+    client->sendReply(RPL_WELCOME(nick, client->getUsername(), client->getHostname()));
+    client->sendReply(RPL_YOURHOST(nick));
+    client->sendReply(RPL_MYINFO(nick));
+    client->sendReply(RPL_ISUPPORT(nick));
+}
+
+// Sends quitMsg to the client's neighbours, then drops client from all
+// of its channels.
 void    Server::broadcastQuitNotification(Client* client, const std::string& quitMsg) {
-    std::vector<std::string> channelNames;
-    std::map<std::string, Channel*>::iterator it;
-    for (it = channels.begin() ; it != channels.end() ; it++) {
-        if (it->second->isMember(client)) {
-            channelNames.push_back(it->first);
-        }
-    }
-    
-    for (size_t i = 0; i < channelNames.size(); i++) {
-        std::map<std::string, Channel*>::iterator found = channels.find(channelNames[i]);
-        if (found != channels.end()) {
-            found->second->broadcast(quitMsg, client);
-            found->second->removeMember(client);
-        }
+    if (client->getChannels().empty())
+        return;
+    broadcastToNeighbours(client, quitMsg, false);
+
+    std::map<Channel*, size_t> joined = client->getChannels();
+    std::map<Channel*, size_t>::iterator it;
+    for (it = joined.begin() ; it != joined.end() ; it++) {
+        it->first->removeMember(client);
     }
 }
 
-std::vector<Channel*>   Server::getClientChannels(Client* client) {
-    std::vector<Channel*> clientChannels;
-    std::map<std::string, Channel*>::iterator it;
-
-    for (it = channels.begin() ; it != channels.end() ; it++) {
-        Channel* channel = it->second;
-        if (channel->isMember(client)) {
-            clientChannels.push_back(channel);
+// Sends msg exactly once to every client sharing at least one channel
+// with client (and to client itself when includeSelf is set). Each pass
+// takes a new epoch and stamps recipients with it, so overlapping
+// channels are deduplicated without building a set.
+void    Server::broadcastToNeighbours(Client* client, const std::string& msg, bool includeSelf) {
+    const std::map<Channel*, size_t>& joined = client->getChannels();
+    std::map<Channel*, size_t>::const_iterator it;
+    unsigned long epoch = ++neighbourEpoch;
+    SharedMessage* shared = SharedMessage::create(msg);
+
+    client->markNeighbour(epoch);
+    if (includeSelf)
+        client->sendMessage(shared);
+    for (it = joined.begin() ; it != joined.end() ; it++) {
+        const std::vector<Membership>& members = it->first->getMembers();
+        for (size_t i = 0 ; i < members.size() ; i++) {
+            if (members[i].client->markNeighbour(epoch))
+                members[i].client->sendMessage(shared);
         }
     }
-    return (clientChannels);
+    shared->release();
 }
 
 void Server::removeChannel(const std::string& name) {
-    std::string lowerName = toLower(name);
-    std::map<std::string, Channel*>::iterator it = channels.find(lowerName);
+    Channel* channel = channels.find(name);
     
-    if (it != channels.end()) {
-        delete it->second;
-        channels.erase(it);
+    if (channel != NULL) {
         std::cout << "  [-] Channel removed: " << name << std::endl;
+        forgetHistory(channel);
+        channels.erase(channel->getFoldedName());
+        delete channel;
     }
 }
 
 bool    Server::channelExistOrNot(const std::string& name) {
-    std::map<std::string, Channel*>::iterator it;
-    
-    std::string lowerName = toLower(name);
-    for (it = channels.begin() ; it != channels.end() ; it++) {
-        Channel* channel = it->second;
-        if (toLower(channel->getName()) == lowerName) {
-            return (true);
-        }
-    }
-    return (false);
+    return (channels.find(name) != NULL);
 }
 
 Channel* Server::getChannel(const std::string& name) {
-    std::map<std::string, Channel*>::iterator it;
+    return (channels.find(name));
+}
 
-    for (it = channels.begin() ; it != channels.end() ; it++) {
-        std::string lowerName = toLower(name);
-        Channel* channel = it->second;
-        if (toLower(channel->getName()) == lowerName) {
-            return (channel);
+Channel* Server::getChannel(const StringView& name) {
+    return (channels.find(name.data, name.length));
+}
+
+// Stores a channel PRIVMSG/NOTICE line in the channel's history, tagged
+// with its time and message id, and indexes its text for SEARCH. Once
+// all histories together exceed history_memory, the least recently used
+// channels lose theirs first.
+void    Server::recordHistory(Channel* channel, const std::string& line, const std::string& text) {
+    size_t capacity = config.getHistoryLines();
+    if (capacity == 0)
+        return;
+
+    // Message ids and timestamps must never go backwards along a ring,
+    // even if the wall clock does.
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    unsigned long nowMs = tv.tv_sec * 1000UL + tv.tv_usec / 1000;
+    if (nowMs < historyClockMs)
+        nowMs = historyClockMs;
+    historyClockMs = nowMs;
+
+    std::ostringstream tagged;
+    tagged << "@batch=" HISTORY_BATCH ";time=" << ChannelHistory::formatTime(nowMs)
+           << ";msgid=" << ++historyIds << " " << line;
+    SharedMessage* shared = SharedMessage::create(tagged.str());
+    ChannelHistory& history = channel->getHistory();
+    size_t before = history.getBytes();
+    history.append(historyIds, nowMs, shared, text, capacity);
+    shared->release();
+    historyBytes = historyBytes - before + history.getBytes();
+    touchHistory(channel);
+
+    while (historyBytes > config.getHistoryMemory() && !historyLru.empty()) {
+        ChannelHistory& coldest = historyLru.back()->getHistory();
+        if (historyLru.size() == 1 && coldest.size() > 1) {
+            before = coldest.getBytes();
+            coldest.dropOldest();
+            historyBytes -= before - coldest.getBytes();
         }
+        else
+            forgetHistory(historyLru.back());
+    }
+}
+
+// Marks channel's history as the most recently used one.
+void    Server::touchHistory(Channel* channel) {
+    ChannelHistory& history = channel->getHistory();
+    if (history.size() == 0)
+        return;
+    if (history.isListed())
+        historyLru.splice(historyLru.begin(), historyLru, history.getLruPosition());
+    else {
+        historyLru.push_front(channel);
+        history.setLruPosition(historyLru.begin());
     }
-    return (NULL);
-}
\ No newline at end of file
+}
+
+void    Server::forgetHistory(Channel* channel) {
+    ChannelHistory& history = channel->getHistory();
+    historyBytes -= history.getBytes();
+    history.clear();
+    if (history.isListed()) {
+        historyLru.erase(history.getLruPosition());
+        history.unlist();
+    }
+}
@@ -0,0 +1,52 @@
+#include "../includes/SharedMessage.hpp"
+
+SharedMessage::SharedMessage(const std::string& msg, bool droppable)
+    : refCount(1), droppable(droppable) {
+    append(msg);
+}
+
+SharedMessage::~SharedMessage() {
+}
+
+SharedMessage* SharedMessage::create(const std::string& msg, bool droppable) {
+    return new SharedMessage(msg, droppable);
+}
+
+void SharedMessage::retain() {
+    refCount++;
+}
+
+void SharedMessage::release() {
+    if (--refCount == 0)
+        delete this;
+}
+
+bool SharedMessage::isShared() const {
+    return (refCount > 1);
+}
+
+bool SharedMessage::isDroppable() const {
+    return droppable;
+}
+
+const std::string& SharedMessage::getData() const {
+    return data;
+}
+
+size_t SharedMessage::length() const {
+    return data.length();
+}
+
+// Only valid while the buffer has a single owner (see isShared()).
+void SharedMessage::append(const std::string& msg) {
+    append(msg.data(), msg.length());
+}
+
+void SharedMessage::append(const char* msg, size_t len) {
+    if (len == 0)
+        return;
+    data.append(msg, len);
+    if (len < 2 || msg[len - 2] != '\r' || msg[len - 1] != '\n') {
+        data.append("\r\n", 2);
+    }
+}
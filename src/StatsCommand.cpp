@@ -0,0 +1,64 @@
+#include "../includes/StatsCommand.hpp"
+#include "../includes/Server.hpp"
+#include "../includes/Client.hpp"
+#include "../includes/Replies.hpp"
+#include "../includes/MessageParser.hpp"
+#include <sstream>
+#include <ctime>
+
+StatsCommand::StatsCommand(Server* srv, Client* cli, const std::vector<std::string>& params)
+    : Command(srv, cli, params) {
+}
+
+StatsCommand::~StatsCommand() {
+}
+
+// STATS l [nick]: link information for one connection (the caller by
+// default), including its current SendQ depth in bytes. Only the
+// caller's own link shows its real address.
+// STATS m: how often each command was used and the bytes it carried.
+void StatsCommand::execute() {
+    std::string nick = client->getNickname();
+    if (nick.empty()) nick = "*";
+    if (!client->isRegistered()) {
+        client->sendReply(ERR_NOTREGISTERED(nick));
+        return;
+    }
+    if (params.empty() || params[0].empty()) {
+        client->sendReply(ERR_NEEDMOREPARAMS(nick, "STATS"));
+        return;
+    }
+
+    std::string query = params[0].substr(0, 1);
+    if (query == "l" || query == "L") {
+        Client* target = client;
+        if (params.size() > 1) {
+            target = server->getClientByNick(params[1]);
+            if (target == NULL) {
+                client->sendReply(ERR_NOSUCHNICK(nick, params[1]));
+                return;
+            }
+        }
+        std::ostringstream info;
+        info << target->getNickname() << "[" << target->getUsername() << "@"
+             << (target == client ? target->getAddress() : target->getHostname()) << "] "
+             << target->getSendQueueBytes() << " "
+             << target->getMessagesQueued() << " "
+             << target->getBytesSent() / 1024 << " "
+             << target->getLinesReceived() << " "
+             << target->getBytesReceived() / 1024 << " :"
+             << (time(NULL) - target->getConnectedAt());
+        client->sendReply(RPL_STATSLINKINFO(nick, info.str()));
+    }
+    else if (query == "m" || query == "M") {
+        size_t count;
+        const CommandEntry* table = MessageParser::getCommandTable(count);
+        for (size_t i = 0; i < count; i++) {
+            if (table[i].calls == 0)
+                continue;
+            client->sendReply(RPL_STATSCOMMANDS(nick, table[i].name,
+                                                table[i].calls, table[i].bytes));
+        }
+    }
+    client->sendReply(RPL_ENDOFSTATS(nick, query));
+}
@@ -0,0 +1,129 @@
+#include "../includes/TimerWheel.hpp"
+
+TimerNode::TimerNode() : prev(NULL), next(NULL), expires(0), fd(-1) {
+}
+
+bool TimerNode::isScheduled() const {
+    return (next != NULL);
+}
+
+TimerWheel::TimerWheel() : current(0), count(0) {
+    for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        for (int i = 0; i < TIMER_WHEEL_SIZE; i++) {
+            slots[level][i].prev = &slots[level][i];
+            slots[level][i].next = &slots[level][i];
+        }
+    }
+}
+
+TimerWheel::~TimerWheel() {
+}
+
+void TimerWheel::reset(unsigned long now) {
+    if (count == 0)
+        current = now;
+}
+
+void TimerWheel::link(TimerNode* node) {
+    unsigned long expires = node->expires;
+    if (expires < current)
+        expires = current;
+    unsigned long delta = expires - current;
+
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1
+           && delta >= (1UL << (TIMER_WHEEL_BITS * (level + 1))))
+        level++;
+    unsigned long maxDelta = (1UL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+    if (delta > maxDelta)
+        expires = current + maxDelta;
+
+    TimerNode* head = &slots[level][(expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+void TimerWheel::unlink(TimerNode* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+void TimerWheel::schedule(TimerNode* node, unsigned long expires) {
+    if (node->isScheduled())
+        unlink(node);
+    else
+        count++;
+    node->expires = expires;
+    link(node);
+}
+
+void TimerWheel::cancel(TimerNode* node) {
+    if (!node->isScheduled())
+        return;
+    unlink(node);
+    count--;
+}
+
+// Re-files every timer of a coarse slot relative to the current tick.
+void TimerWheel::cascade(int level, size_t index) {
+    TimerNode* head = &slots[level][index];
+    TimerNode* node = head->next;
+
+    head->prev = head;
+    head->next = head;
+    while (node != head) {
+        TimerNode* next = node->next;
+        link(node);
+        node = next;
+    }
+}
+
+// Turns the wheel up to tick 'now' and moves every expired timer into
+// 'expired'. Expired timers are unscheduled and may be rescheduled.
+void TimerWheel::advance(unsigned long now, std::vector<TimerNode*>& expired) {
+    while (current <= now) {
+        size_t index = current & TIMER_WHEEL_MASK;
+        if (index == 0) {
+            for (int level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+                size_t levelIndex = (current >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+                cascade(level, levelIndex);
+                if (levelIndex != 0)
+                    break;
+            }
+        }
+        TimerNode* head = &slots[0][index];
+        while (head->next != head) {
+            TimerNode* node = head->next;
+            unlink(node);
+            count--;
+            expired.push_back(node);
+        }
+        current++;
+    }
+}
+
+// Number of ticks the caller may sleep without missing a timer: the
+// distance to the next busy slot of the finest level, or to the next
+// cascade, whichever comes first.
+unsigned long TimerWheel::ticksUntilNext() const {
+    unsigned long untilCascade = (TIMER_WHEEL_SIZE - (current & TIMER_WHEEL_MASK)) & TIMER_WHEEL_MASK;
+
+    for (unsigned long i = 0; i < untilCascade; i++) {
+        const TimerNode* head = &slots[0][(current + i) & TIMER_WHEEL_MASK];
+        if (head->next != head)
+            return i;
+    }
+    return untilCascade;
+}
+
+unsigned long TimerWheel::getCurrent() const {
+    return current;
+}
+
+size_t TimerWheel::size() const {
+    return count;
+}
@@ -11,29 +11,29 @@ TopicCommand::~TopicCommand() {
 
 void TopicCommand::execute() {
     if (!this->client->isRegistered()) {
-        this->client->sendMessage(ERR_NOTREGISTERED(this->client->getNickname()) + "\r\n");
+        this->client->sendReply(ERR_NOTREGISTERED(this->client->getNickname()));
         return;
     }
     if (this->params.empty()) {
-        this->client->sendMessage(ERR_NEEDMOREPARAMS(this->client->getNickname(), "TOPIC") + "\r\n");
+        this->client->sendReply(ERR_NEEDMOREPARAMS(this->client->getNickname(), "TOPIC"));
         return;
     }
     Channel *channel = this->server->getChannel(this->params[0]);
     if (channel == NULL) {
-        this->client->sendMessage(ERR_NOSUCHCHANNEL(this->client->getNickname(), this->params[0]) + "\r\n");
+        this->client->sendReply(ERR_NOSUCHCHANNEL(this->client->getNickname(), this->params[0]));
         return;
     }
     if (!channel->isMember(this->client)) {
-        this->client->sendMessage(ERR_NOTONCHANNEL(this->client->getNickname(), this->params[0]) + "\r\n");
+        this->client->sendReply(ERR_NOTONCHANNEL(this->client->getNickname(), this->params[0]));
         return;
     }
     if (this->params.size() == 1) {
         std::string topic = channel->getTopic();
         if (topic.empty()) {
-            this->client->sendMessage(RPL_NOTOPIC(this->client->getNickname(), this->params[0]) + "\r\n");
+            this->client->sendReply(RPL_NOTOPIC(this->client->getNickname(), this->params[0]));
             return;
         }
-        this->client->sendMessage(RPL_TOPIC(this->client->getNickname(), this->params[0], topic) + "\r\n");
+        this->client->sendReply(RPL_TOPIC(this->client->getNickname(), this->params[0], topic));
     }
     else {
         std::string topic = this->params[1];
@@ -41,7 +41,7 @@ void TopicCommand::execute() {
             topic = topic.substr(1);
         }
         if (channel->getRestriction() && !channel->isOperator(client)) {
-            this->client->sendMessage(ERR_CHANOPRIVSNEEDED(this->client->getNickname(), this->params[0]) + "\r\n");
+            this->client->sendReply(ERR_CHANOPRIVSNEEDED(this->client->getNickname(), this->params[0]));
             return;
         }
         channel->setTopic(topic, this->client);